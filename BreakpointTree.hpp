@@ -6,6 +6,8 @@
 #include <cassert>
 #include <algorithm>
 #include <iomanip>
+#include <limits>
+#include <xmmintrin.h>
 #include "Byte.hpp"
 #include "ExecutableMemory.hpp"
 
@@ -45,6 +47,22 @@ void tree_print(BreakpointTree const* node, uint32_t whitespace) {
 	}
 }
 
+uint32_t tree_height(BreakpointTree const* node) {
+	if (node == nullptr) {
+		return 0;
+	}
+	return 1 + std::max(tree_height(node->left), tree_height(node->right));
+}
+
+void tree_collect(BreakpointTree const* node, std::vector<BreakpointTree const*>& nodes) {
+	if (node == nullptr) {
+		return;
+	}
+	tree_collect(node->left, nodes);
+	nodes.push_back(node);
+	tree_collect(node->right, nodes);
+}
+
 BreakpointTree* build_tree_impl(const std::vector<float>& intervals, std::size_t left, std::size_t right) {
 	if (left >= right) {
 		return nullptr;
@@ -100,10 +118,65 @@ int32_t interval_search_binary(const std::vector<float>& intervals, const float
 	return -1;
 }
 
+// Same answer as interval_search_binary without the unpredictable branches: the loop always runs
+// log2(size) times and the compiler turns the select into a cmov.
+int32_t interval_search_branchless(const std::vector<float>& intervals, const float value) noexcept {
+	assert(intervals.size() >= 1);
+	assert(intervals.size() <= INT32_MAX);
+	const float* base = intervals.data();
+	std::size_t length = intervals.size();
+	while (length > 1) {
+		std::size_t half = length / 2;
+		base = (base[half] <= value) ? base + half : base;
+		length -= half;
+	}
+	// Number of breakpoints <= value, NaN is never <= so it lands below every interval
+	std::size_t rank = (std::size_t)(base - intervals.data()) + (*base <= value);
+	if (rank == 0 || rank == intervals.size()) {
+		return -1;
+	}
+	return (int32_t)rank - 1;
+}
+
+template <const auto& Breakpoints, std::size_t Left, std::size_t Right>
+constexpr int32_t interval_search_static_impl(const float value) noexcept {
+	if constexpr (Left >= Right) {
+		// Exactly Left breakpoints are <= value
+		constexpr int32_t index = (Left == 0 || Left == std::size(Breakpoints)) ? -1 : (int32_t)Left - 1;
+		return index;
+	}
+	else {
+		constexpr std::size_t breakpoint = Left + (Right - Left) / 2;
+		if (value >= Breakpoints[breakpoint]) {
+			return interval_search_static_impl<Breakpoints, breakpoint + 1, Right>(value);
+		}
+		return interval_search_static_impl<Breakpoints, Left, breakpoint>(value);
+	}
+}
+
+// Compile time counterpart of the JIT for breakpoints known at compile time: the same tree as
+// build_tree unrolled into nested comparisons against constants. Breakpoints must be a constexpr
+// array with static storage duration, e.g. interval_search_static<my_breakpoints>(value).
+template <const auto& Breakpoints>
+constexpr int32_t interval_search_static(const float value) noexcept {
+	static_assert(std::size(Breakpoints) >= 1);
+	static_assert(std::size(Breakpoints) <= INT32_MAX);
+	static_assert(std::is_sorted(std::begin(Breakpoints), std::end(Breakpoints)));
+	return interval_search_static_impl<Breakpoints, 0, std::size(Breakpoints)>(value);
+}
+
 namespace CodegenInterval {
+	struct ReturnTable {
+		uint32_t label;
+		std::vector<int32_t> values;
+	};
+
 	struct ASM_context {
 		uint32_t global_label_counter;
 		uint32_t global_return_counter;
+		uint32_t interval_count;
+		uint32_t branchless_levels;
+		std::vector<ReturnTable> return_tables;
 	};
 
 	struct LabelDefinition {
@@ -112,7 +185,8 @@ namespace CodegenInterval {
 
 	enum struct UsageType {
 		JUMP,
-		DEFERENCE
+		DEFERENCE,
+		ADDRESS // lea of a label, the definition marks the start of the data
 	};
 
 	struct LabelUsage {
@@ -121,6 +195,45 @@ namespace CodegenInterval {
 		UsageType type;
 	};
 
+	// Resolves a whole subtree without branches. eax counts the breakpoints that value is below
+	// (comiss sets CF for value < breakpoint and for NaN), which indexes a table of the returned values.
+	void codegen_branchless_impl(
+		BreakpointTree const* node,
+		std::vector<Byte>& bytes,
+		std::vector<LabelUsage>& label_usages,
+		std::vector<float>& numbers,
+		ASM_context& context
+	) {
+		std::vector<BreakpointTree const*> nodes = {};
+		tree_collect(node, nodes);
+
+		write_bytes(xor_eax_eax, bytes);
+		for (const auto& n : nodes) {
+			numbers.push_back(n->value);
+			write_bytes(comiss_xmm0_DWORD_PTR_rip_PLUS_0x00000000, bytes);
+			label_usages.push_back(LabelUsage{ .start_offset = bytes.size() - 4, .id = (uint32_t)numbers.size() - 1, .type = UsageType::DEFERENCE });
+			write_bytes(adc_eax_0x00, bytes);
+		}
+
+		auto table_label = context.global_label_counter++;
+		write_bytes(lea_rcx_rip_PLUS_0x00000000, bytes);
+		label_usages.push_back(LabelUsage{ .start_offset = bytes.size() - 4, .id = table_label, .type = UsageType::ADDRESS });
+		write_bytes(mov_eax_DWORD_PTR_rcx_PLUS_rax_TIMES_4, bytes);
+		write_bytes(ret, bytes);
+
+		// When value is below `below` of the subtree's breakpoints, rank = last - below breakpoints are <= value;
+		// rank 0 and rank interval_count are outside of every interval.
+		const auto first = (uint32_t)nodes.front()->index;
+		const auto last = first + (uint32_t)nodes.size();
+		ReturnTable table = { .label = table_label, .values = {} };
+		for (uint32_t below = 0; below <= nodes.size(); below++) {
+			auto rank = last - below;
+			table.values.push_back((rank == 0 || rank == context.interval_count) ? -1 : (int32_t)rank - 1);
+		}
+		context.return_tables.push_back(std::move(table));
+		context.global_return_counter = last;
+	}
+
 	void codegen_impl(
 		BreakpointTree const* node,
 		std::vector<Byte>& bytes,
@@ -131,6 +244,12 @@ namespace CodegenInterval {
 		uint32_t leftCount,
 		uint32_t rightCount
 	) {
+		// Skip the tree_height walk when the default keeps a branch on every node
+		if (context.branchless_levels != 0 && node != nullptr && tree_height(node) <= context.branchless_levels) {
+			codegen_branchless_impl(node, bytes, label_usages, numbers, context);
+			return;
+		}
+
 		numbers.push_back(node->value);
 
 		write_bytes(comiss_xmm0_DWORD_PTR_rip_PLUS_0x00000000, bytes);
@@ -237,11 +356,40 @@ namespace CodegenInterval {
 		}
 	}
 
-	std::vector<Byte> codegen(const std::vector<float>& intervals, BreakpointTree const* root) {
+	void resolve_labels(std::vector<Byte>& bytes, const std::map<uint32_t, LabelDefinition>& label_defintions, const std::vector<LabelUsage>& label_usages) {
+		Byte* ptr_no_offset = bytes.data();
+		for (const auto& usage : label_usages) {
+			Byte* bptr = ptr_no_offset + usage.start_offset;
+			uint32_t* ptr = (uint32_t*)bptr;
+			if (const auto iter = label_defintions.find(usage.id); iter != label_defintions.end()) {
+				auto& def = iter->second;
+				if (usage.type == UsageType::DEFERENCE) {
+					*ptr = def.start_offset - usage.start_offset - 8;
+				}
+				else if (usage.type == UsageType::JUMP || usage.type == UsageType::ADDRESS) {
+					*ptr = def.start_offset - usage.start_offset - 4;
+				}
+				else {
+					throw std::exception("Unknown usage type received.");
+				}
+			}
+			else {
+				throw std::exception("Could not find label definition.");
+			}
+		}
+	}
+
+	std::vector<Byte> codegen(const std::vector<float>& intervals, BreakpointTree const* root, uint32_t branchless_levels = 0) {
 		// C ABI calling convention: In this case we are passed "value" via xmm0 and we return into eax
 		std::map<uint32_t, CodegenInterval::LabelDefinition> label_defintions = {}; // label counter -> defintion
 		std::vector<CodegenInterval::LabelUsage> label_usages = {};
-		CodegenInterval::ASM_context context = { .global_label_counter = (uint32_t)intervals.size() + 10, .global_return_counter = 0 };
+		CodegenInterval::ASM_context context = {
+			.global_label_counter = (uint32_t)intervals.size() + 10,
+			.global_return_counter = 0,
+			.interval_count = (uint32_t)intervals.size(),
+			.branchless_levels = branchless_levels,
+			.return_tables = {}
+		};
 
 		std::vector<float> numbers = {};
 		std::vector<Byte> bytes = {};
@@ -253,40 +401,240 @@ namespace CodegenInterval {
 				CodegenInterval::LabelDefinition{.start_offset = bytes.size() }
 			});
 		}
-		Byte* ptr_no_offset = bytes.data();
-		for (const auto& usage : label_usages) {
-			Byte* bptr = ptr_no_offset + usage.start_offset;
-			uint32_t* ptr = (uint32_t*)bptr;
-			if (const auto iter = label_defintions.find(usage.id); iter != label_defintions.end()) {
-				auto& def = iter->second;
-				if (usage.type == CodegenInterval::UsageType::DEFERENCE) {
-					*ptr = def.start_offset - usage.start_offset - 8;
-				}
-				else if (usage.type == CodegenInterval::UsageType::JUMP) {
-					*ptr = def.start_offset - usage.start_offset - 4;
-				}
-				else {
-					throw std::exception("Unknown usage type received.");
+		for (const auto& table : context.return_tables) {
+			label_defintions.insert({ table.label, CodegenInterval::LabelDefinition{.start_offset = bytes.size() } });
+			for (const auto& value : table.values) {
+				write_bytes<int32_t>(value, bytes);
+			}
+		}
+		resolve_labels(bytes, label_defintions, label_usages);
+		return bytes;
+	}
+};
+
+namespace CodegenIntervalKary {
+	// Implicit (width + 1)-ary search tree with every level stored contiguously, root first.
+	// The leaves hold every breakpoint in sorted order, an internal node holds the first breakpoint
+	// of each of its children except the first one. Missing breakpoints are NaN, which is never
+	// counted by the >= comparison, so the padding never changes the result.
+	struct Layout {
+		uint32_t width;
+		std::vector<std::size_t> level_offsets; // Byte offset of every level from the start of data
+		std::vector<float> data;
+		// Leaf nodes are leaf_scale node sizes apart and their breakpoints start leaf_key_offset bytes
+		// into the node, so other data can sit next to the breakpoints of a leaf
+		uint32_t leaf_scale = 1;
+		uint32_t leaf_key_offset = 0;
+	};
+
+	Layout build_layout(const std::vector<float>& intervals, uint32_t width) {
+		const float padding = std::numeric_limits<float>::quiet_NaN();
+		std::vector<std::size_t> level_counts = { (intervals.size() + width - 1) / width };
+		while (level_counts.back() > 1) {
+			level_counts.push_back((level_counts.back() + width) / (width + 1));
+		}
+		std::reverse(level_counts.begin(), level_counts.end());
+
+		Layout layout = { .width = width, .level_offsets = {}, .data = {} };
+		for (std::size_t level = 0; level < level_counts.size(); level++) {
+			layout.level_offsets.push_back(layout.data.size() * sizeof(float));
+			// Number of leaves below a child of a node on this level
+			std::size_t child_span = 1;
+			for (std::size_t i = level + 2; i < level_counts.size(); i++) {
+				child_span *= width + 1;
+			}
+			for (std::size_t node = 0; node < level_counts.at(level); node++) {
+				for (std::size_t i = 0; i < width; i++) {
+					std::size_t breakpoint = 0;
+					if (level + 1 == level_counts.size()) {
+						breakpoint = node * width + i;
+					}
+					else {
+						breakpoint = (node * (width + 1) + i + 1) * child_span * width;
+					}
+					layout.data.push_back(breakpoint < intervals.size() ? intervals.at(breakpoint) : padding);
 				}
 			}
+		}
+		return layout;
+	}
+
+	// Leaves the byte offset of the leaf inside of the leaf level in rdx and the number of its breakpoints
+	// that are <= the value in xmm{source} in eax. rcx points to the layout's data, which goes at data_label.
+	// Clobbers ymm4/k1 and ymm5/zmm5.
+	void codegen_descend(
+		const Layout& layout,
+		uint32_t source,
+		uint32_t data_label,
+		std::vector<Byte>& bytes,
+		std::vector<CodegenInterval::LabelUsage>& label_usages
+	) {
+		assert(layout.width == 8 || layout.width == 16);
+		assert(source <= 3);
+		assert(layout.data.size() * sizeof(float) <= INT32_MAX);
+		const std::vector<Byte>* broadcasts_ymm[] = { &vbroadcastss_ymm5_xmm0, &vbroadcastss_ymm5_xmm1, &vbroadcastss_ymm5_xmm2, &vbroadcastss_ymm5_xmm3 };
+		const std::vector<Byte>* broadcasts_zmm[] = { &vbroadcastss_zmm5_xmm0, &vbroadcastss_zmm5_xmm1, &vbroadcastss_zmm5_xmm2, &vbroadcastss_zmm5_xmm3 };
+		const auto width = layout.width;
+
+		write_bytes(width == 8 ? *broadcasts_ymm[source] : *broadcasts_zmm[source], bytes);
+		write_bytes(lea_rcx_rip_PLUS_0x00000000, bytes);
+		label_usages.push_back(CodegenInterval::LabelUsage{ .start_offset = bytes.size() - 4, .id = data_label, .type = CodegenInterval::UsageType::ADDRESS });
+		// rdx is the byte offset of the current node inside of its level
+		write_bytes(xor_edx_edx, bytes);
+		for (std::size_t level = 0; level < layout.level_offsets.size(); level++) {
+			// eax = number of breakpoints in the node that are <= value
+			auto node_offset = (uint32_t)layout.level_offsets.at(level);
+			if (level + 1 == layout.level_offsets.size()) {
+				node_offset += layout.leaf_key_offset;
+			}
+			if (width == 8) {
+				write_bytes(vcmpps_ymm4_ymm5_YMMWORD_PTR_rcx_PLUS_rdx_PLUS_MISSING_4_BYTES, bytes);
+				write_bytes<uint32_t>(node_offset, bytes);
+				write_bytes(CMP_PREDICATE_GE_OQ, bytes);
+				write_bytes(vmovmskps_eax_ymm4, bytes);
+			}
 			else {
-				throw std::exception("Could not find label definition.");
+				write_bytes(vcmpps_k1_zmm5_ZMMWORD_PTR_rcx_PLUS_rdx_PLUS_MISSING_4_BYTES, bytes);
+				write_bytes<uint32_t>(node_offset, bytes);
+				write_bytes(CMP_PREDICATE_GE_OQ, bytes);
+				write_bytes(kmovw_eax_k1, bytes);
+			}
+			write_bytes(popcnt_eax_eax, bytes);
+			if (level + 1 < layout.level_offsets.size()) {
+				// rdx = rdx * (width + 1) + eax * node size, the offset of child eax on the next level
+				write_bytes(imul_rdx_rdx_MISSING_1_BYTE, bytes);
+				write_bytes<Byte>(width + 1, bytes);
+				write_bytes(shl_eax_MISSING_1_BYTE, bytes);
+				write_bytes<Byte>(width == 8 ? 5 : 6, bytes);
+				write_bytes(add_rdx_rax, bytes);
+				if (level + 2 == layout.level_offsets.size() && layout.leaf_scale != 1) {
+					write_bytes(imul_rdx_rdx_MISSING_1_BYTE, bytes);
+					write_bytes<Byte>((Byte)layout.leaf_scale, bytes);
+				}
 			}
 		}
+	}
+
+	// Leaves the number of breakpoints <= the value in xmm{source} in eax. The layout's data goes at data_label.
+	// Clobbers rcx, rdx, ymm4/k1 and ymm5/zmm5.
+	void codegen_rank(
+		const Layout& layout,
+		uint32_t source,
+		uint32_t data_label,
+		std::vector<Byte>& bytes,
+		std::vector<CodegenInterval::LabelUsage>& label_usages
+	) {
+		assert(layout.leaf_scale == 1 && layout.leaf_key_offset == 0);
+		codegen_descend(layout, source, data_label, bytes, label_usages);
+		// The leaf offset divided by sizeof(float) is the number of breakpoints in the leaves before it
+		write_bytes(shr_rdx_MISSING_1_BYTE, bytes);
+		write_bytes<Byte>(2, bytes);
+		write_bytes(add_eax_edx, bytes);
+	}
+
+	void codegen_data(
+		const Layout& layout,
+		uint32_t data_label,
+		std::vector<Byte>& bytes,
+		std::map<uint32_t, CodegenInterval::LabelDefinition>& label_definitions
+	) {
+		// exec_memory_create is page aligned, so aligning the data keeps every node in as few cache lines as possible
+		while (bytes.size() % 64 != 0) {
+			write_bytes(int3, bytes);
+		}
+		label_definitions.insert({ data_label, CodegenInterval::LabelDefinition{.start_offset = bytes.size() } });
+		for (const auto& value : layout.data) {
+			write_bytes<float>(value, bytes);
+		}
+	}
+
+	std::vector<Byte> codegen(const std::vector<float>& intervals, uint32_t width) {
+		// C ABI calling convention: In this case we are passed "value" via xmm0 and we return into eax
+		const auto layout = build_layout(intervals, width);
+		const uint32_t data_label = 0;
+
+		std::map<uint32_t, CodegenInterval::LabelDefinition> label_defintions = {};
+		std::vector<CodegenInterval::LabelUsage> label_usages = {};
+		std::vector<Byte> bytes = {};
+
+		codegen_rank(layout, 0, data_label, bytes, label_usages);
+		// The interval is eax - 1 when 1 <= eax < size
+		write_bytes(dec_eax, bytes);
+		write_bytes(mov_edx_MISSING_4_BYTES, bytes);
+		write_bytes<int32_t>(-1, bytes);
+		write_bytes(cmp_eax_MISSING_4_BYTES, bytes);
+		write_bytes<uint32_t>((uint32_t)intervals.size() - 1, bytes);
+		write_bytes(cmovae_eax_edx, bytes);
+		write_bytes(vzeroupper, bytes);
+		write_bytes(ret, bytes);
+
+		codegen_data(layout, data_label, bytes, label_defintions);
+		CodegenInterval::resolve_labels(bytes, label_defintions, label_usages);
 		return bytes;
 	}
 };
 
+enum struct IntervalSearchLayout {
+	BINARY_TREE, // One comiss and conditional jump per tree node
+	KARY_AVX_8, // 8 breakpoints per node compared at once with 256 bit AVX, no branches. Requires AVX2.
+	KARY_AVX512_16 // 16 breakpoints per node compared at once with AVX-512, no branches. Requires AVX-512F.
+};
+
+struct IntervalSearchOptions {
+	IntervalSearchLayout layout = IntervalSearchLayout::BINARY_TREE;
+	// BINARY_TREE only: subtrees at most this many levels high are resolved with comiss/adc and a
+	// table of returned values instead of branches. 0 keeps a branch on every node.
+	uint32_t branchless_levels = 0;
+};
+
+// Number of breakpoints per node of a KARY layout, after checking that the CPU runs the emitted code.
+// The register form of vbroadcastss is AVX2 (AVX only has the memory form) and every AVX2 or AVX-512F
+// CPU also has popcnt.
+uint32_t kary_layout_width(IntervalSearchLayout layout) {
+	switch (layout) {
+	case IntervalSearchLayout::KARY_AVX_8:
+		if (!IsProcessorFeaturePresent(PF_AVX2_INSTRUCTIONS_AVAILABLE)) {
+			throw std::exception("KARY_AVX_8 requires AVX2.");
+		}
+		return 8;
+	case IntervalSearchLayout::KARY_AVX512_16:
+		if (!IsProcessorFeaturePresent(PF_AVX512F_INSTRUCTIONS_AVAILABLE)) {
+			throw std::exception("KARY_AVX512_16 requires AVX-512F.");
+		}
+		return 16;
+	default:
+		throw std::exception("Not a KARY layout.");
+	}
+}
+
+// Every layout takes value in xmm0, returns into eax and only clobbers rax, rcx, rdx, xmm4 and xmm5
+// (and their ymm/zmm/k1 parts). Code emitted next to it can keep its own state in r8-r11 and xmm0-xmm3.
+std::vector<Byte> interval_search_codegen(const std::vector<float>& intervals, const IntervalSearchOptions& options) {
+	assert(intervals.size() >= 1);
+	assert(intervals.size() <= INT32_MAX);
+	switch (options.layout) {
+	case IntervalSearchLayout::BINARY_TREE: {
+		auto tree = build_tree(intervals);
+		// tree_print(tree, 0);
+		auto bytes = CodegenInterval::codegen(intervals, tree, options.branchless_levels);
+		delete tree;
+		return bytes;
+	}
+	case IntervalSearchLayout::KARY_AVX_8:
+	case IntervalSearchLayout::KARY_AVX512_16:
+		return CodegenIntervalKary::codegen(intervals, kary_layout_width(options.layout));
+	default:
+		throw std::exception("Unknown interval search layout.");
+	}
+}
+
 class ExeIntervalSearch {
 	using FUNC_PTR = int32_t(*)(float);
 	void* memory;
 public:
-	explicit ExeIntervalSearch(const std::vector<float>& intervals) {
-		auto tree = build_tree(intervals);
-		// tree_print(tree, 0);
-		auto bytes = CodegenInterval::codegen(intervals, tree);
+	explicit ExeIntervalSearch(const std::vector<float>& intervals, const IntervalSearchOptions& options = {}) {
+		auto bytes = interval_search_codegen(intervals, options);
 		memory = exec_memory_create(bytes);
-		delete tree;
 	}
 	~ExeIntervalSearch() {
 		exec_memory_delete(memory);
@@ -295,6 +643,16 @@ public:
 		FUNC_PTR ptr = (FUNC_PTR)memory;
 		return ptr(value);
 	}
+	void run_batch(const float* values, int32_t* results, std::size_t count) const noexcept {
+		FUNC_PTR ptr = (FUNC_PTR)memory;
+		for (std::size_t i = 0; i < count; i++) {
+			if (i % 16 == 0) {
+				// One cache line of values at a time, a few lines ahead. Prefetching past the end never faults.
+				_mm_prefetch((const char*)(values + i) + 512, _MM_HINT_T0);
+			}
+			results[i] = ptr(values[i]);
+		}
+	}
 };
 
 #endif // !_HEADER_BREAKPOINT_TREE_HPP_
@@ -67,4 +67,313 @@ const std::vector<Byte> cmp_edi_MISSING_1_BYTE = {
 	0x83, 0xFF, 0x00
 };
 
+// Used to pad between code and data, traps if it is ever executed
+const Byte int3 = 0xCC;
+const std::vector<Byte> lea_rcx_rip_PLUS_0x00000000 = {
+	0x48, 0x8D, 0x0D, 0x00, 0x00, 0x00, 0x00
+};
+const std::vector<Byte> xor_edx_edx = {
+	0x31, 0xD2
+};
+const std::vector<Byte> vbroadcastss_ymm5_xmm0 = {
+	0xC4, 0xE2, 0x7D, 0x18, 0xE8
+};
+const std::vector<Byte> vbroadcastss_ymm5_xmm1 = {
+	0xC4, 0xE2, 0x7D, 0x18, 0xE9
+};
+const std::vector<Byte> vbroadcastss_ymm5_xmm2 = {
+	0xC4, 0xE2, 0x7D, 0x18, 0xEA
+};
+const std::vector<Byte> vbroadcastss_ymm5_xmm3 = {
+	0xC4, 0xE2, 0x7D, 0x18, 0xEB
+};
+const std::vector<Byte> vbroadcastss_zmm5_xmm0 = {
+	0x62, 0xF2, 0x7D, 0x48, 0x18, 0xE8
+};
+const std::vector<Byte> vbroadcastss_zmm5_xmm1 = {
+	0x62, 0xF2, 0x7D, 0x48, 0x18, 0xE9
+};
+const std::vector<Byte> vbroadcastss_zmm5_xmm2 = {
+	0x62, 0xF2, 0x7D, 0x48, 0x18, 0xEA
+};
+const std::vector<Byte> vbroadcastss_zmm5_xmm3 = {
+	0x62, 0xF2, 0x7D, 0x48, 0x18, 0xEB
+};
+// The comparison predicate immediate follows the 4 byte displacement
+const std::vector<Byte> vcmpps_ymm4_ymm5_YMMWORD_PTR_rcx_PLUS_rdx_PLUS_MISSING_4_BYTES = {
+	0xC5, 0xD4, 0xC2, 0xA4, 0x11
+};
+const std::vector<Byte> vcmpps_k1_zmm5_ZMMWORD_PTR_rcx_PLUS_rdx_PLUS_MISSING_4_BYTES = {
+	0x62, 0xF1, 0x54, 0x48, 0xC2, 0x8C, 0x11
+};
+// x >= breakpoint, false when either side is NaN
+const Byte CMP_PREDICATE_GE_OQ = 0x1D;
+const std::vector<Byte> vmovmskps_eax_ymm4 = {
+	0xC5, 0xFC, 0x50, 0xC4
+};
+const std::vector<Byte> kmovw_eax_k1 = {
+	0xC5, 0xF8, 0x93, 0xC1
+};
+const std::vector<Byte> popcnt_eax_eax = {
+	0xF3, 0x0F, 0xB8, 0xC0
+};
+const std::vector<Byte> imul_rdx_rdx_MISSING_1_BYTE = {
+	0x48, 0x6B, 0xD2
+};
+const std::vector<Byte> shl_eax_MISSING_1_BYTE = {
+	0xC1, 0xE0
+};
+const std::vector<Byte> add_rdx_rax = {
+	0x48, 0x01, 0xC2
+};
+const std::vector<Byte> shr_rdx_MISSING_1_BYTE = {
+	0x48, 0xC1, 0xEA
+};
+const std::vector<Byte> add_eax_edx = {
+	0x01, 0xD0
+};
+const std::vector<Byte> dec_eax = {
+	0xFF, 0xC8
+};
+const std::vector<Byte> mov_edx_MISSING_4_BYTES = {
+	0xBA
+};
+const std::vector<Byte> cmp_eax_MISSING_4_BYTES = {
+	0x3D
+};
+const std::vector<Byte> cmovae_eax_edx = {
+	0x0F, 0x43, 0xC2
+};
+const std::vector<Byte> xor_eax_eax = {
+	0x31, 0xC0
+};
+// Adds the carry flag, after comiss it is set when xmm0 < operand or unordered
+const std::vector<Byte> adc_eax_0x00 = {
+	0x83, 0xD0, 0x00
+};
+const std::vector<Byte> mov_eax_DWORD_PTR_rcx_PLUS_rax_TIMES_4 = {
+	0x8B, 0x04, 0x81
+};
+const std::vector<Byte> je_0x00000000 = {
+	0x0F, 0x84, 0x00, 0x00, 0x00, 0x00
+};
+const std::vector<Byte> call_0x00000000 = {
+	0xE8, 0x00, 0x00, 0x00, 0x00
+};
+const std::vector<Byte> mov_r10_rcx = {
+	0x49, 0x89, 0xCA
+};
+const std::vector<Byte> mov_r11_rdx = {
+	0x49, 0x89, 0xD3
+};
+const std::vector<Byte> test_r11_r11 = {
+	0x4D, 0x85, 0xDB
+};
+const std::vector<Byte> movss_xmm0_DWORD_PTR_r10 = {
+	0xF3, 0x41, 0x0F, 0x10, 0x02
+};
+const std::vector<Byte> movsxd_rax_eax = {
+	0x48, 0x63, 0xC0
+};
+const std::vector<Byte> inc_QWORD_PTR_r8_PLUS_rax_TIMES_8_PLUS_0x08 = {
+	0x49, 0xFF, 0x44, 0xC0, 0x08
+};
+const std::vector<Byte> cvtss2sd_xmm1_DWORD_PTR_r9 = {
+	0xF3, 0x41, 0x0F, 0x5A, 0x09
+};
+const std::vector<Byte> addsd_xmm1_QWORD_PTR_r8_PLUS_rax_TIMES_8_PLUS_0x08 = {
+	0xF2, 0x41, 0x0F, 0x58, 0x4C, 0xC0, 0x08
+};
+const std::vector<Byte> movsd_QWORD_PTR_r8_PLUS_rax_TIMES_8_PLUS_0x08_xmm1 = {
+	0xF2, 0x41, 0x0F, 0x11, 0x4C, 0xC0, 0x08
+};
+const std::vector<Byte> add_r9_0x04 = {
+	0x49, 0x83, 0xC1, 0x04
+};
+const std::vector<Byte> add_r10_0x04 = {
+	0x49, 0x83, 0xC2, 0x04
+};
+const std::vector<Byte> dec_r11 = {
+	0x49, 0xFF, 0xCB
+};
+const std::vector<Byte> jl_0x00000000 = {
+	0x0F, 0x8C, 0x00, 0x00, 0x00, 0x00
+};
+const std::vector<Byte> jmp_0x00000000 = {
+	0xE9, 0x00, 0x00, 0x00, 0x00
+};
+const std::vector<Byte> jmp_rax = {
+	0xFF, 0xE0
+};
+const std::vector<Byte> mov_eax_ecx = {
+	0x89, 0xC8
+};
+const std::vector<Byte> mov_ecx_edx = {
+	0x89, 0xD1
+};
+const std::vector<Byte> lea_rdx_rip_PLUS_0x00000000 = {
+	0x48, 0x8D, 0x15, 0x00, 0x00, 0x00, 0x00
+};
+const std::vector<Byte> movsxd_rax_DWORD_PTR_rdx_PLUS_rax_TIMES_4 = {
+	0x48, 0x63, 0x04, 0x82
+};
+const std::vector<Byte> add_rax_rdx = {
+	0x48, 0x01, 0xD0
+};
+// Often used for unsigned range checks
+const std::vector<Byte> ja_0x00000000 = {
+	0x0F, 0x87, 0x00, 0x00, 0x00, 0x00
+};
+const std::vector<Byte> lea_eax_rcx_PLUS_MISSING_4_BYTES = {
+	0x8D, 0x81
+};
+const std::vector<Byte> mov_edx_eax = {
+	0x89, 0xC2
+};
+const std::vector<Byte> mov_edx_ecx = {
+	0x89, 0xCA
+};
+const std::vector<Byte> mov_rax_rdx = {
+	0x48, 0x89, 0xD0
+};
+const std::vector<Byte> shr_edx_MISSING_1_BYTE = {
+	0xC1, 0xEA
+};
+const std::vector<Byte> shr_rax_MISSING_1_BYTE = {
+	0x48, 0xC1, 0xE8
+};
+const std::vector<Byte> lea_r8_rip_PLUS_0x00000000 = {
+	0x4C, 0x8D, 0x05, 0x00, 0x00, 0x00, 0x00
+};
+const std::vector<Byte> mov_rdx_QWORD_PTR_r8_PLUS_rdx_TIMES_8 = {
+	0x49, 0x8B, 0x14, 0xD0
+};
+const std::vector<Byte> mov_rax_QWORD_PTR_r8_PLUS_rax_TIMES_8 = {
+	0x49, 0x8B, 0x04, 0xC0
+};
+// CF = bit (rax mod 64) of rdx
+const std::vector<Byte> bt_rdx_rax = {
+	0x48, 0x0F, 0xA3, 0xC2
+};
+const std::vector<Byte> imul_rdx_rax = {
+	0x48, 0x0F, 0xAF, 0xD0
+};
+const std::vector<Byte> xor_r9d_r9d = {
+	0x45, 0x31, 0xC9
+};
+// Sets bit (rdx mod 64) of r9
+const std::vector<Byte> bts_r9_rdx = {
+	0x49, 0x0F, 0xAB, 0xD1
+};
+const std::vector<Byte> not_rax = {
+	0x48, 0xF7, 0xD0
+};
+const std::vector<Byte> test_rax_r9 = {
+	0x4C, 0x85, 0xC8
+};
+const std::vector<Byte> xor_r8d_r8d = {
+	0x45, 0x31, 0xC0
+};
+const std::vector<Byte> mov_r9d_MISSING_4_BYTES = {
+	0x41, 0xB9
+};
+// edx = -1 if the carry flag is set, 0 otherwise
+const std::vector<Byte> sbb_edx_edx = {
+	0x19, 0xD2
+};
+const std::vector<Byte> and_r9d_edx = {
+	0x41, 0x21, 0xD1
+};
+const std::vector<Byte> imul_r8d_r8d_MISSING_4_BYTES = {
+	0x45, 0x69, 0xC0
+};
+const std::vector<Byte> add_r8d_eax = {
+	0x41, 0x01, 0xC0
+};
+const std::vector<Byte> mov_eax_r8d = {
+	0x44, 0x89, 0xC0
+};
+const std::vector<Byte> test_r9d_r9d = {
+	0x45, 0x85, 0xC9
+};
+const std::vector<Byte> cmove_eax_edx = {
+	0x0F, 0x44, 0xC2
+};
+const std::vector<Byte> jb_0x00000000 = {
+	0x0F, 0x82, 0x00, 0x00, 0x00, 0x00
+};
+const std::vector<Byte> cmp_rdx_MISSING_4_BYTES = {
+	0x48, 0x81, 0xFA
+};
+// The 4 byte constant is sign extended
+const std::vector<Byte> cmp_rax_MISSING_4_BYTES = {
+	0x48, 0x3D
+};
+const std::vector<Byte> mov_r9_MISSING_8_BYTES = {
+	0x49, 0xB9
+};
+const std::vector<Byte> cmp_rax_r9 = {
+	0x4C, 0x39, 0xC8
+};
+const std::vector<Byte> mov_rax_QWORD_PTR_rcx_PLUS_MISSING_4_BYTES = {
+	0x48, 0x8B, 0x81
+};
+const std::vector<Byte> mov_eax_DWORD_PTR_rcx = {
+	0x8B, 0x01
+};
+const std::vector<Byte> mov_r8d_DWORD_PTR_rcx_PLUS_MISSING_4_BYTES = {
+	0x44, 0x8B, 0x81
+};
+const std::vector<Byte> shl_r8_0x20 = {
+	0x49, 0xC1, 0xE0, 0x20
+};
+const std::vector<Byte> or_rax_r8 = {
+	0x4C, 0x09, 0xC0
+};
+const std::vector<Byte> movzx_eax_WORD_PTR_rcx = {
+	0x0F, 0xB7, 0x01
+};
+const std::vector<Byte> movzx_r8d_WORD_PTR_rcx_PLUS_MISSING_4_BYTES = {
+	0x44, 0x0F, 0xB7, 0x81
+};
+const std::vector<Byte> shl_r8d_0x10 = {
+	0x41, 0xC1, 0xE0, 0x10
+};
+const std::vector<Byte> or_eax_r8d = {
+	0x44, 0x09, 0xC0
+};
+const std::vector<Byte> movzx_eax_BYTE_PTR_rcx = {
+	0x0F, 0xB6, 0x01
+};
+const std::vector<Byte> vzeroupper = {
+	0xC5, 0xF8, 0x77
+};
+const std::vector<Byte> subss_xmm0_DWORD_PTR_rcx_PLUS_rdx_PLUS_MISSING_4_BYTES = {
+	0xF3, 0x0F, 0x5C, 0x84, 0x11
+};
+const std::vector<Byte> movss_xmm1_DWORD_PTR_rcx_PLUS_rdx_PLUS_MISSING_4_BYTES = {
+	0xF3, 0x0F, 0x10, 0x8C, 0x11
+};
+const std::vector<Byte> mulss_xmm1_xmm0 = {
+	0xF3, 0x0F, 0x59, 0xC8
+};
+const std::vector<Byte> addss_xmm1_DWORD_PTR_rcx_PLUS_rdx_PLUS_MISSING_4_BYTES = {
+	0xF3, 0x0F, 0x58, 0x8C, 0x11
+};
+const std::vector<Byte> movaps_xmm0_xmm1 = {
+	0x0F, 0x28, 0xC1
+};
+const std::vector<Byte> test_r8_r8 = {
+	0x4D, 0x85, 0xC0
+};
+const std::vector<Byte> movss_DWORD_PTR_r11_xmm0 = {
+	0xF3, 0x41, 0x0F, 0x11, 0x03
+};
+const std::vector<Byte> add_r11_0x04 = {
+	0x49, 0x83, 0xC3, 0x04
+};
+const std::vector<Byte> dec_r8 = {
+	0x49, 0xFF, 0xC8
+};
+
 #endif // !_HEADER_BYTE_HPP_
@@ -0,0 +1,123 @@
+#ifndef _HEADER_GRID_SEARCH_HPP_
+#define _HEADER_GRID_SEARCH_HPP_
+
+#include <vector>
+#include <map>
+#include <utility>
+#include <cassert>
+#include "Byte.hpp"
+#include "ExecutableMemory.hpp"
+#include "BreakpointTree.hpp"
+
+namespace CodegenGrid {
+	// C ABI calling convention: axis i is passed via xmm{i} and we return the flattened cell into eax,
+	// ((index0 * cells1 + index1) * cells2 + index2)..., or -1 if the point is outside on any axis.
+	// Every axis is a branchless k-ary rank with its own dependency chain, so the out of order core
+	// runs the axes side by side. r8d accumulates the cell and r9d stays -1 while every axis is inside.
+	std::vector<Byte> codegen(const std::vector<std::vector<float>>& axes, uint32_t width) {
+		std::map<uint32_t, CodegenInterval::LabelDefinition> label_defintions = {};
+		std::vector<CodegenInterval::LabelUsage> label_usages = {};
+		std::vector<CodegenIntervalKary::Layout> layouts = {};
+		std::vector<Byte> bytes = {};
+
+		write_bytes(xor_r8d_r8d, bytes);
+		write_bytes(mov_r9d_MISSING_4_BYTES, bytes);
+		write_bytes<int32_t>(-1, bytes);
+		for (uint32_t axis = 0; axis < axes.size(); axis++) {
+			const auto& intervals = axes.at(axis);
+			layouts.push_back(CodegenIntervalKary::build_layout(intervals, width));
+			CodegenIntervalKary::codegen_rank(layouts.back(), axis, axis, bytes, label_usages);
+
+			// eax = index on this axis, valid when below the number of cells of this axis
+			const auto cells = (uint32_t)intervals.size() - 1;
+			write_bytes(dec_eax, bytes);
+			write_bytes(cmp_eax_MISSING_4_BYTES, bytes);
+			write_bytes<uint32_t>(cells, bytes);
+			write_bytes(sbb_edx_edx, bytes);
+			write_bytes(and_r9d_edx, bytes);
+			write_bytes(imul_r8d_r8d_MISSING_4_BYTES, bytes);
+			write_bytes<uint32_t>(cells, bytes);
+			write_bytes(add_r8d_eax, bytes);
+		}
+		write_bytes(mov_eax_r8d, bytes);
+		write_bytes(mov_edx_MISSING_4_BYTES, bytes);
+		write_bytes<int32_t>(-1, bytes);
+		write_bytes(test_r9d_r9d, bytes);
+		write_bytes(cmove_eax_edx, bytes);
+		write_bytes(vzeroupper, bytes);
+		write_bytes(ret, bytes);
+
+		for (uint32_t axis = 0; axis < layouts.size(); axis++) {
+			CodegenIntervalKary::codegen_data(layouts.at(axis), axis, bytes, label_defintions);
+		}
+		CodegenInterval::resolve_labels(bytes, label_defintions, label_usages);
+		return bytes;
+	}
+};
+
+// Buckets points on a grid of 1 to 4 axes in one call. Each axis is a sorted breakpoint vector like
+// the one ExeIntervalSearch takes, the result is the row-major index of the cell or -1.
+class ExeGridSearch {
+	void* memory;
+	std::size_t axis_count;
+
+	template <std::size_t... Axis>
+	void run_batch_impl(const float* const* columns, int32_t* results, std::size_t count, std::index_sequence<Axis...>) const noexcept {
+		using FUNC_PTR = int32_t(*)(decltype((void)Axis, 0.0f)...);
+		FUNC_PTR ptr = (FUNC_PTR)memory;
+		for (std::size_t i = 0; i < count; i++) {
+			results[i] = ptr(columns[Axis][i]...);
+		}
+	}
+public:
+	explicit ExeGridSearch(const std::vector<std::vector<float>>& axes, const IntervalSearchOptions& options = { .layout = IntervalSearchLayout::KARY_AVX_8 }) : axis_count{ axes.size() } {
+		if (axes.size() < 1 || axes.size() > 4) {
+			throw std::exception("ExeGridSearch supports 1 to 4 axes.");
+		}
+		uint64_t cells = 1;
+		for (const auto& intervals : axes) {
+			assert(intervals.size() >= 1);
+			cells *= intervals.size() - 1;
+			if (cells > INT32_MAX) {
+				throw std::exception("Too many cells to index with int32_t.");
+			}
+		}
+		if (options.layout == IntervalSearchLayout::BINARY_TREE) {
+			throw std::exception("ExeGridSearch only supports the KARY layouts.");
+		}
+		const auto width = kary_layout_width(options.layout);
+		auto bytes = CodegenGrid::codegen(axes, width);
+		memory = exec_memory_create(bytes);
+	}
+	~ExeGridSearch() {
+		exec_memory_delete(memory);
+	}
+	// One value per axis, e.g. run(price, size)
+	template <typename... Values>
+	int32_t run(Values... values) const noexcept {
+		static_assert(sizeof...(Values) >= 1 && sizeof...(Values) <= 4);
+		assert(sizeof...(Values) == axis_count);
+		using FUNC_PTR = int32_t(*)(decltype((void)values, 0.0f)...);
+		FUNC_PTR ptr = (FUNC_PTR)memory;
+		return ptr((float)values...);
+	}
+	// Structure of arrays input, columns[axis][i] is the coordinate of point i on that axis
+	void run_batch(const float* const* columns, int32_t* results, std::size_t count) const noexcept {
+		switch (axis_count) {
+		case 1:
+			run_batch_impl(columns, results, count, std::make_index_sequence<1>());
+			break;
+		case 2:
+			run_batch_impl(columns, results, count, std::make_index_sequence<2>());
+			break;
+		case 3:
+			run_batch_impl(columns, results, count, std::make_index_sequence<3>());
+			break;
+		case 4:
+			run_batch_impl(columns, results, count, std::make_index_sequence<4>());
+			break;
+		}
+	}
+};
+
+#endif // !_HEADER_GRID_SEARCH_HPP_
@@ -0,0 +1,139 @@
+#ifndef _HEADER_INTERVAL_AGGREGATE_HPP_
+#define _HEADER_INTERVAL_AGGREGATE_HPP_
+
+#include <vector>
+#include <map>
+#include <span>
+#include <algorithm>
+#include "Byte.hpp"
+#include "ExecutableMemory.hpp"
+#include "BreakpointTree.hpp"
+#include "WorkStealingPool.hpp"
+
+namespace CodegenAggregate {
+	enum struct Kind {
+		HISTOGRAM,
+		SUM
+	};
+
+	// Emits a loop over values which calls the search at offset 0 and updates accumulators[index + 1],
+	// so accumulators[0] collects the values outside of every interval.
+	// C ABI calling convention: values in rcx, count in rdx, accumulators in r8 and weights in r9.
+	// The loop state lives in r8-r11 and xmm1, which the search leaves alone.
+	void codegen_loop(std::vector<Byte>& bytes, Kind kind) {
+		const uint32_t search_label = 0;
+		const uint32_t loop_label = 1;
+		const uint32_t done_label = 2;
+		std::map<uint32_t, CodegenInterval::LabelDefinition> label_defintions = {
+			{ search_label, CodegenInterval::LabelDefinition{.start_offset = 0 } }
+		};
+		std::vector<CodegenInterval::LabelUsage> label_usages = {};
+
+		write_bytes(mov_r10_rcx, bytes);
+		write_bytes(mov_r11_rdx, bytes);
+		write_bytes(test_r11_r11, bytes);
+		write_bytes(je_0x00000000, bytes);
+		label_usages.push_back(CodegenInterval::LabelUsage{ .start_offset = bytes.size() - 4, .id = done_label, .type = CodegenInterval::UsageType::JUMP });
+
+		label_defintions.insert({ loop_label, CodegenInterval::LabelDefinition{.start_offset = bytes.size() } });
+		write_bytes(movss_xmm0_DWORD_PTR_r10, bytes);
+		write_bytes(call_0x00000000, bytes);
+		label_usages.push_back(CodegenInterval::LabelUsage{ .start_offset = bytes.size() - 4, .id = search_label, .type = CodegenInterval::UsageType::JUMP });
+		write_bytes(movsxd_rax_eax, bytes);
+		if (kind == Kind::HISTOGRAM) {
+			write_bytes(inc_QWORD_PTR_r8_PLUS_rax_TIMES_8_PLUS_0x08, bytes);
+		}
+		else {
+			write_bytes(cvtss2sd_xmm1_DWORD_PTR_r9, bytes);
+			write_bytes(addsd_xmm1_QWORD_PTR_r8_PLUS_rax_TIMES_8_PLUS_0x08, bytes);
+			write_bytes(movsd_QWORD_PTR_r8_PLUS_rax_TIMES_8_PLUS_0x08_xmm1, bytes);
+			write_bytes(add_r9_0x04, bytes);
+		}
+		write_bytes(add_r10_0x04, bytes);
+		write_bytes(dec_r11, bytes);
+		write_bytes(jne_0x00000000, bytes);
+		label_usages.push_back(CodegenInterval::LabelUsage{ .start_offset = bytes.size() - 4, .id = loop_label, .type = CodegenInterval::UsageType::JUMP });
+
+		label_defintions.insert({ done_label, CodegenInterval::LabelDefinition{.start_offset = bytes.size() } });
+		write_bytes(ret, bytes);
+		CodegenInterval::resolve_labels(bytes, label_defintions, label_usages);
+	}
+
+	std::size_t align_code(std::vector<Byte>& bytes) {
+		while (bytes.size() % 16 != 0) {
+			write_bytes(int3, bytes);
+		}
+		return bytes.size();
+	}
+};
+
+// Classifies values and updates a per interval histogram or sum in the same pass.
+// Slot 0 of the results is for values outside of every interval, slot i + 1 for interval i.
+class ExeIntervalAggregate {
+	using HISTOGRAM_PTR = void(*)(const float*, std::size_t, uint64_t*, const float*);
+	using SUM_PTR = void(*)(const float*, std::size_t, double*, const float*);
+	void* memory;
+	std::size_t histogram_offset;
+	std::size_t sum_offset;
+	std::size_t slots;
+
+	template <typename T, typename Kernel>
+	std::vector<T> run_parallel(std::size_t count, WorkStealingPool& pool, std::size_t chunk_size, const Kernel& kernel) const {
+		assert(chunk_size >= 1);
+		// One accumulator array per worker, reduced at the end
+		std::vector<std::vector<T>> per_worker(pool.worker_count(), std::vector<T>(slots));
+		const auto chunk_count = (count + chunk_size - 1) / chunk_size;
+		pool.parallel_for(chunk_count, [&](std::size_t worker, std::size_t chunk) {
+			const auto begin = chunk * chunk_size;
+			kernel(begin, std::min(chunk_size, count - begin), per_worker.at(worker).data());
+		});
+		std::vector<T> result(slots);
+		for (const auto& accumulators : per_worker) {
+			for (std::size_t i = 0; i < slots; i++) {
+				result[i] += accumulators[i];
+			}
+		}
+		return result;
+	}
+public:
+	explicit ExeIntervalAggregate(const std::vector<float>& intervals, const IntervalSearchOptions& options = {}) : slots{ intervals.size() } {
+		auto bytes = interval_search_codegen(intervals, options);
+		histogram_offset = CodegenAggregate::align_code(bytes);
+		CodegenAggregate::codegen_loop(bytes, CodegenAggregate::Kind::HISTOGRAM);
+		sum_offset = CodegenAggregate::align_code(bytes);
+		CodegenAggregate::codegen_loop(bytes, CodegenAggregate::Kind::SUM);
+		memory = exec_memory_create(bytes);
+	}
+	~ExeIntervalAggregate() {
+		exec_memory_delete(memory);
+	}
+	// Number of accumulators the results need, one per interval plus one for the values outside
+	std::size_t slot_count() const noexcept {
+		return slots;
+	}
+	// Adds the number of values in every interval to counts
+	void histogram(const float* values, std::size_t count, uint64_t* counts) const noexcept {
+		HISTOGRAM_PTR ptr = (HISTOGRAM_PTR)((Byte*)memory + histogram_offset);
+		ptr(values, count, counts, nullptr);
+	}
+	// Adds the weights of the values in every interval to sums
+	void sum(const float* values, const float* weights, std::size_t count, double* sums) const noexcept {
+		SUM_PTR ptr = (SUM_PTR)((Byte*)memory + sum_offset);
+		ptr(values, count, sums, weights);
+	}
+	std::vector<uint64_t> histogram(std::span<const float> values, WorkStealingPool& pool, std::size_t chunk_size = 32 * 1024) const {
+		return run_parallel<uint64_t>(values.size(), pool, chunk_size, [&](std::size_t begin, std::size_t count, uint64_t* counts) {
+			histogram(values.data() + begin, count, counts);
+		});
+	}
+	std::vector<double> sum(std::span<const float> values, std::span<const float> weights, WorkStealingPool& pool, std::size_t chunk_size = 32 * 1024) const {
+		if (weights.size() < values.size()) {
+			throw std::exception("Fewer weights than values.");
+		}
+		return run_parallel<double>(values.size(), pool, chunk_size, [&](std::size_t begin, std::size_t count, double* sums) {
+			sum(values.data() + begin, weights.data() + begin, count, sums);
+		});
+	}
+};
+
+#endif // !_HEADER_INTERVAL_AGGREGATE_HPP_
@@ -0,0 +1,126 @@
+#ifndef _HEADER_INTERVAL_PIPELINE_HPP_
+#define _HEADER_INTERVAL_PIPELINE_HPP_
+
+#define NOMINMAX
+#include <windows.h>
+#include <span>
+#include <cassert>
+#include <string>
+#include <algorithm>
+#include "WorkStealingPool.hpp"
+
+// Whole file mapped into memory, read only or read write.
+class MappedFile {
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+	void* view = nullptr;
+	std::size_t length = 0;
+
+	void map(DWORD protection, DWORD access) {
+		if (length == 0) {
+			// Windows refuses to map empty files
+			return;
+		}
+		mapping = CreateFileMappingA(file, nullptr, protection, (DWORD)(length >> 32), (DWORD)length, nullptr);
+		if (mapping == nullptr) {
+			CloseHandle(file);
+			throw std::exception("Could not create file mapping.");
+		}
+		view = MapViewOfFile(mapping, access, 0, 0, length);
+		if (view == nullptr) {
+			CloseHandle(mapping);
+			CloseHandle(file);
+			throw std::exception("Could not map view of file.");
+		}
+	}
+public:
+	// Opens an existing file for reading
+	explicit MappedFile(const std::string& path) {
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			throw std::exception("Could not open file.");
+		}
+		LARGE_INTEGER size = {};
+		if (!GetFileSizeEx(file, &size)) {
+			CloseHandle(file);
+			throw std::exception("Could not read file size.");
+		}
+		length = (std::size_t)size.QuadPart;
+		map(PAGE_READONLY, FILE_MAP_READ);
+	}
+	// Creates (or truncates) a file of the given size for writing
+	explicit MappedFile(const std::string& path, std::size_t size) : length{ size } {
+		file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			throw std::exception("Could not create file.");
+		}
+		map(PAGE_READWRITE, FILE_MAP_WRITE);
+	}
+	~MappedFile() {
+		if (view != nullptr) {
+			UnmapViewOfFile(view);
+		}
+		if (mapping != nullptr) {
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+	}
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	std::size_t size() const noexcept {
+		return length;
+	}
+	template <typename T>
+	std::span<T> as_span() const noexcept {
+		return std::span<T>((T*)view, length / sizeof(T));
+	}
+};
+
+struct PipelineOptions {
+	// Values per chunk, 32Ki floats in and 32Ki indices out stay inside of L2
+	std::size_t chunk_size = 32 * 1024;
+	// Ask the OS to fault in the pages of the worker's next chunk while it works on the current one,
+	// mostly useful for memory mapped input
+	bool prefetch_pages = true;
+};
+
+// Classifies input into output chunk by chunk on the pool. Searcher needs a thread safe
+// run_batch(const float*, int32_t*, std::size_t), like ExeIntervalSearch.
+// Chunks are dealt to the workers in contiguous ranges, so each worker writes a contiguous part of
+// output and steals from workers on its own NUMA node first. The pages of output only land on the
+// writing worker's node if they have not been touched yet, e.g. new int32_t[n] rather than a zero
+// filled std::vector. Pages of a mapped file are in the page cache and placed by the OS.
+template <typename Searcher>
+void pipeline_classify(const Searcher& searcher, std::span<const float> input, std::span<int32_t> output, WorkStealingPool& pool, const PipelineOptions& options = {}) {
+	assert(options.chunk_size >= 1);
+	if (output.size() < input.size()) {
+		throw std::exception("Output is smaller than input.");
+	}
+	const auto chunk_count = (input.size() + options.chunk_size - 1) / options.chunk_size;
+	pool.parallel_for(chunk_count, [&](std::size_t, std::size_t chunk) {
+		const auto begin = chunk * options.chunk_size;
+		const auto count = std::min(options.chunk_size, input.size() - begin);
+		if (options.prefetch_pages && chunk + 1 < chunk_count) {
+			const auto next_begin = begin + count;
+			const auto next_count = std::min(options.chunk_size, input.size() - next_begin);
+			WIN32_MEMORY_RANGE_ENTRY range = {
+				.VirtualAddress = (PVOID)(input.data() + next_begin),
+				.NumberOfBytes = next_count * sizeof(float)
+			};
+			PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+		}
+		searcher.run_batch(input.data() + begin, output.data() + begin, count);
+	});
+}
+
+// Classifies a file of raw floats into a file of raw int32_t indices
+template <typename Searcher>
+void pipeline_classify_file(const Searcher& searcher, const std::string& input_path, const std::string& output_path, WorkStealingPool& pool, const PipelineOptions& options = {}) {
+	MappedFile input(input_path);
+	const auto values = input.as_span<const float>();
+	MappedFile output(output_path, values.size() * sizeof(int32_t));
+	pipeline_classify(searcher, values, output.as_span<int32_t>(), pool, options);
+}
+
+#endif // !_HEADER_INTERVAL_PIPELINE_HPP_
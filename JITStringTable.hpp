@@ -0,0 +1,261 @@
+#ifndef _HEADER_JIT_STRING_TABLE_HPP_
+#define _HEADER_JIT_STRING_TABLE_HPP_
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <map>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+#include "Byte.hpp"
+#include "ExecutableMemory.hpp"
+#include "JITable.hpp"
+
+namespace CodegenString {
+	using Entry = std::pair<std::string, void*>;
+	using CodegenTable::LabelDefinition;
+	using CodegenTable::LabelUsage;
+	using CodegenTable::UsageType;
+
+	// A key of length L is compared as chunk_count(L) 64 bit words. Keys of 8 bytes or more use
+	// 8 byte loads with the last one overlapping the previous, shorter keys combine two overlapping
+	// 4, 2 or 1 byte loads. No load ever reads outside of [data, data + L).
+	std::size_t chunk_count(std::size_t length) noexcept {
+		if (length == 0) {
+			return 0;
+		}
+		if (length < 8) {
+			return 1;
+		}
+		return (length + 7) / 8;
+	}
+
+	// Same value as the code emitted by codegen_load_chunk, for a key of the same length
+	uint64_t chunk_value(const std::string& key, std::size_t chunk) noexcept {
+		const auto length = key.size();
+		const char* data = key.data();
+		if (length >= 8) {
+			auto offset = (chunk + 1 == chunk_count(length)) ? length - 8 : chunk * 8;
+			uint64_t value = 0;
+			std::memcpy(&value, data + offset, 8);
+			return value;
+		}
+		if (length >= 4) {
+			uint32_t low = 0;
+			uint32_t high = 0;
+			std::memcpy(&low, data, 4);
+			std::memcpy(&high, data + length - 4, 4);
+			return (uint64_t)low | ((uint64_t)high << 32);
+		}
+		if (length >= 2) {
+			uint16_t low = 0;
+			uint16_t high = 0;
+			std::memcpy(&low, data, 2);
+			std::memcpy(&high, data + length - 2, 2);
+			return (uint64_t)low | ((uint64_t)high << 16);
+		}
+		return (uint64_t)(unsigned char)data[0];
+	}
+
+	// rax = chunk of the key at rcx, the length is known here
+	void codegen_load_chunk(std::size_t length, std::size_t chunk, std::vector<Byte>& bytes) {
+		if (length >= 8) {
+			auto offset = (chunk + 1 == chunk_count(length)) ? length - 8 : chunk * 8;
+			write_bytes(mov_rax_QWORD_PTR_rcx_PLUS_MISSING_4_BYTES, bytes);
+			write_bytes<uint32_t>((uint32_t)offset, bytes);
+		}
+		else if (length >= 4) {
+			write_bytes(mov_eax_DWORD_PTR_rcx, bytes);
+			write_bytes(mov_r8d_DWORD_PTR_rcx_PLUS_MISSING_4_BYTES, bytes);
+			write_bytes<uint32_t>((uint32_t)length - 4, bytes);
+			write_bytes(shl_r8_0x20, bytes);
+			write_bytes(or_rax_r8, bytes);
+		}
+		else if (length >= 2) {
+			write_bytes(movzx_eax_WORD_PTR_rcx, bytes);
+			write_bytes(movzx_r8d_WORD_PTR_rcx_PLUS_MISSING_4_BYTES, bytes);
+			write_bytes<uint32_t>((uint32_t)length - 2, bytes);
+			write_bytes(shl_r8d_0x10, bytes);
+			write_bytes(or_eax_r8d, bytes);
+		}
+		else {
+			write_bytes(movzx_eax_BYTE_PTR_rcx, bytes);
+		}
+	}
+
+	void codegen_cmp_rax(uint64_t value, std::vector<Byte>& bytes) {
+		if ((int64_t)value >= INT32_MIN && (int64_t)value <= INT32_MAX) {
+			write_bytes(cmp_rax_MISSING_4_BYTES, bytes);
+			write_bytes<int32_t>((int32_t)(int64_t)value, bytes);
+		}
+		else {
+			write_bytes(mov_r9_MISSING_8_BYTES, bytes);
+			write_bytes<uint64_t>(value, bytes);
+			write_bytes(cmp_rax_r9, bytes);
+		}
+	}
+
+	// Jumps to the label when below/above, or to not found when there is no label
+	void codegen_branch(const std::vector<Byte>& jump, bool exists, uint32_t label, uint32_t not_found_label, std::vector<Byte>& bytes, std::vector<LabelUsage>& label_usages) {
+		write_bytes(jump, bytes);
+		label_usages.push_back(LabelUsage{ .start_offset = bytes.size() - 4, .id = exists ? label : not_found_label, .type = UsageType::JUMP });
+	}
+
+	struct Context {
+		std::vector<Byte> bytes;
+		std::map<uint32_t, LabelDefinition> label_definitions;
+		std::vector<LabelUsage> label_usages;
+		CodegenTable::ASM_context asm_context;
+		CodegenTable::SharedStubs stubs;
+	};
+
+	void codegen_chunks(const std::vector<const Entry*>& entries, std::size_t length, std::size_t chunk, Context& context);
+
+	// Binary search over the distinct values of one chunk, rax holds the chunk
+	void codegen_chunk_tree(
+		const std::vector<std::pair<uint64_t, std::vector<const Entry*>>>& groups,
+		std::size_t left,
+		std::size_t right,
+		std::size_t length,
+		std::size_t chunk,
+		Context& context
+	) {
+		auto middle = left + (right - left) / 2;
+		auto below_label = context.asm_context.global_label_counter++;
+		auto above_label = context.asm_context.global_label_counter++;
+		codegen_cmp_rax(groups.at(middle).first, context.bytes);
+		codegen_branch(jb_0x00000000, left < middle, below_label, context.stubs.not_found_label, context.bytes, context.label_usages);
+		codegen_branch(ja_0x00000000, middle + 1 < right, above_label, context.stubs.not_found_label, context.bytes, context.label_usages);
+
+		// rax == chunk, move on to the next chunk
+		codegen_chunks(groups.at(middle).second, length, chunk + 1, context);
+
+		if (left < middle) {
+			context.label_definitions.insert({ below_label, LabelDefinition{.start_offset = context.bytes.size() } });
+			codegen_chunk_tree(groups, left, middle, length, chunk, context);
+		}
+		if (middle + 1 < right) {
+			context.label_definitions.insert({ above_label, LabelDefinition{.start_offset = context.bytes.size() } });
+			codegen_chunk_tree(groups, middle + 1, right, length, chunk, context);
+		}
+	}
+
+	// Every entry has the given length and the same chunks before this one
+	void codegen_chunks(const std::vector<const Entry*>& entries, std::size_t length, std::size_t chunk, Context& context) {
+		if (chunk == chunk_count(length)) {
+			// Every chunk matched, this is the key
+			auto value = entries.front()->second;
+			if (!context.stubs.value_labels.contains(value)) {
+				context.stubs.value_labels.insert({ value, context.asm_context.global_label_counter++ });
+			}
+			write_bytes(jmp_0x00000000, context.bytes);
+			context.label_usages.push_back(LabelUsage{ .start_offset = context.bytes.size() - 4, .id = context.stubs.value_labels.at(value), .type = UsageType::JUMP });
+			return;
+		}
+		std::map<uint64_t, std::vector<const Entry*>> by_chunk = {};
+		for (const auto& entry : entries) {
+			by_chunk[chunk_value(entry->first, chunk)].push_back(entry);
+		}
+		std::vector<std::pair<uint64_t, std::vector<const Entry*>>> groups(by_chunk.begin(), by_chunk.end());
+		codegen_load_chunk(length, chunk, context.bytes);
+		codegen_chunk_tree(groups, 0, groups.size(), length, chunk, context);
+	}
+
+	// Binary search over the distinct key lengths, rdx holds the length
+	void codegen_length_tree(
+		const std::vector<std::pair<std::size_t, std::vector<const Entry*>>>& groups,
+		std::size_t left,
+		std::size_t right,
+		Context& context
+	) {
+		auto middle = left + (right - left) / 2;
+		auto below_label = context.asm_context.global_label_counter++;
+		auto above_label = context.asm_context.global_label_counter++;
+		write_bytes(cmp_rdx_MISSING_4_BYTES, context.bytes);
+		write_bytes<uint32_t>((uint32_t)groups.at(middle).first, context.bytes);
+		codegen_branch(jb_0x00000000, left < middle, below_label, context.stubs.not_found_label, context.bytes, context.label_usages);
+		codegen_branch(ja_0x00000000, middle + 1 < right, above_label, context.stubs.not_found_label, context.bytes, context.label_usages);
+
+		codegen_chunks(groups.at(middle).second, groups.at(middle).first, 0, context);
+
+		if (left < middle) {
+			context.label_definitions.insert({ below_label, LabelDefinition{.start_offset = context.bytes.size() } });
+			codegen_length_tree(groups, left, middle, context);
+		}
+		if (middle + 1 < right) {
+			context.label_definitions.insert({ above_label, LabelDefinition{.start_offset = context.bytes.size() } });
+			codegen_length_tree(groups, middle + 1, right, context);
+		}
+	}
+
+	// C ABI calling convention: data in rcx, length in rdx, the value is returned into rax (0 when not found).
+	std::vector<Byte> codegen(const std::vector<Entry>& entries) {
+		Context context = {};
+		context.asm_context = { .global_label_counter = 0, .global_return_counter = 0 };
+		context.stubs = { .not_found_label = context.asm_context.global_label_counter++, .value_labels = {} };
+
+		std::map<std::size_t, std::vector<const Entry*>> by_length = {};
+		for (const auto& entry : entries) {
+			if (entry.first.size() > INT32_MAX) {
+				throw std::exception("Key is too long.");
+			}
+			by_length[entry.first.size()].push_back(&entry);
+		}
+		std::vector<std::pair<std::size_t, std::vector<const Entry*>>> groups(by_length.begin(), by_length.end());
+		if (groups.empty()) {
+			write_bytes(jmp_0x00000000, context.bytes);
+			context.label_usages.push_back(LabelUsage{ .start_offset = context.bytes.size() - 4, .id = context.stubs.not_found_label, .type = UsageType::JUMP });
+		}
+		else {
+			codegen_length_tree(groups, 0, groups.size(), context);
+		}
+
+		context.label_definitions.insert({ context.stubs.not_found_label, LabelDefinition{.start_offset = context.bytes.size() } });
+		write_bytes(xor_eax_eax, context.bytes);
+		write_bytes(ret, context.bytes);
+		for (const auto& [value, label] : context.stubs.value_labels) {
+			context.label_definitions.insert({ label, LabelDefinition{.start_offset = context.bytes.size() } });
+			write_bytes(mov_rax_MISSING_8_BYTES, context.bytes);
+			write_bytes(value, context.bytes);
+			write_bytes(ret, context.bytes);
+		}
+		CodegenTable::resolve_labels(context.bytes, context.label_definitions, context.label_usages);
+		return context.bytes;
+	}
+};
+
+// Static set of string keys compiled into a decision tree: first on the length, then on the
+// key's 8 byte chunks compared against immediates.
+class ExeStringTable {
+	using FUNC_PTR = uint64_t(*)(const char*, std::size_t);
+	void* memory;
+public:
+	explicit ExeStringTable(const std::unordered_map<std::string, void*>& basic_table) {
+		std::vector<CodegenString::Entry> entries = {};
+		entries.reserve(basic_table.size());
+		for (const auto& kv : basic_table) {
+			if (kv.second == nullptr) {
+				throw std::exception("Not allowed to have a value be nullptr");
+			}
+			entries.push_back(kv);
+		}
+		std::sort(entries.begin(), entries.end());
+		auto bytes = CodegenString::codegen(entries);
+		memory = exec_memory_create(bytes);
+	}
+	~ExeStringTable() {
+		exec_memory_delete(memory);
+	}
+	// Returns 0 (nullptr) when the key is not in the table
+	uint64_t run(const char* data, std::size_t length) const noexcept {
+		FUNC_PTR ptr = (FUNC_PTR)memory;
+		return ptr(data, length);
+	}
+	uint64_t run(std::string_view key) const noexcept {
+		return run(key.data(), key.size());
+	}
+};
+
+#endif // !_HEADER_JIT_STRING_TABLE_HPP_
@@ -4,9 +4,11 @@
 #include <utility>
 #include <unordered_map>
 #include <map>
+#include <memory>
 #include <cassert>
 #include <algorithm>
 #include <limits>
+#include <cstdint>
 #include "Byte.hpp"
 
 class JITableTree {
@@ -43,19 +45,120 @@ JITableTree* build_table_tree_impl(const std::vector<std::pair<int32_t, void*>>&
 	}
 }
 
+// The keys must be unique
+JITableTree* build_table_tree(std::vector<std::pair<int32_t, void*>> kv_pairs) {
+	for (const auto& kv : kv_pairs) {
+		if (kv.second == nullptr) {
+			throw std::exception("Not allowed to have a value be nullptr");
+		}
+	}
+	// Callers that already sorted the pairs, like TieredTable, only pay for the check
+	if (!std::is_sorted(kv_pairs.begin(), kv_pairs.end())) {
+		std::sort(kv_pairs.begin(), kv_pairs.end());
+	}
+	return build_table_tree_impl(kv_pairs, 0, kv_pairs.size());
+}
+
 JITableTree* build_table_tree(const std::unordered_map<int32_t, void*>& basic_table) {
 	std::vector<std::pair<int32_t, void*>> kv_pairs = {};
 	kv_pairs.reserve(basic_table.size() + 10);
 	for (const auto& kv_map : basic_table) {
-		if (kv_map.second == nullptr) {
-			throw std::exception("Not allowed to have a value be nullptr");
-		}
 		kv_pairs.push_back(kv_map);
 	}
-	std::sort(kv_pairs.begin(), kv_pairs.end());
-	return build_table_tree_impl(kv_pairs, 0, kv_pairs.size());
+	return build_table_tree(std::move(kv_pairs));
 }
 
+enum struct TablePrefilter {
+	NONE,
+	RANGE, // Rejects keys outside of [min key, max key]
+	BITMAP, // RANGE, then one bit for every key in [min key, max key]
+	BLOOM // RANGE, then a blocked Bloom filter: 3 bits in one 64 bit word per key
+};
+
+struct TableOptions {
+	TablePrefilter prefilter = TablePrefilter::NONE;
+	uint32_t bloom_bits_per_key = 16;
+	uint64_t bitmap_max_bits = 1ull << 27; // 16MiB
+};
+
+// Cheap test run at the top of the generated function, most misses return before the search tree.
+// may_contain mirrors the generated code exactly so callers can measure how many misses it catches.
+class JITablePrefilter {
+public:
+	TablePrefilter kind = TablePrefilter::NONE;
+	int32_t min_key = 0;
+	int32_t max_key = 0;
+	uint32_t log2_words = 0; // BLOOM only
+	std::vector<uint64_t> words = {};
+
+	static const uint64_t BLOOM_MULTIPLIER = 0x9E3779B97F4A7C15ull;
+	static const uint32_t BLOOM_MAX_LOG2_WORDS = 24; // The word index stays clear of the bits used for the mask
+	static const uint32_t BLOOM_BIT_SHIFT = 20;
+
+	// The word is taken from the top bits of the hash, the 3 bit positions from bits 20 to 37
+	static uint64_t bloom_hash(int32_t key) noexcept {
+		return (uint64_t)(uint32_t)key * BLOOM_MULTIPLIER;
+	}
+	static uint64_t bloom_mask(uint64_t hash) noexcept {
+		auto bits = hash >> BLOOM_BIT_SHIFT;
+		return (1ull << (bits & 63)) | (1ull << ((bits >> 6) & 63)) | (1ull << ((bits >> 12) & 63));
+	}
+
+	static JITablePrefilter build(const std::vector<int32_t>& sorted_keys, const TableOptions& options) {
+		JITablePrefilter filter = {};
+		filter.kind = options.prefilter;
+		if (filter.kind == TablePrefilter::NONE || sorted_keys.empty()) {
+			filter.kind = TablePrefilter::NONE;
+			return filter;
+		}
+		filter.min_key = sorted_keys.front();
+		filter.max_key = sorted_keys.back();
+		const uint64_t span = (uint64_t)((int64_t)filter.max_key - (int64_t)filter.min_key) + 1;
+		if (filter.kind == TablePrefilter::BITMAP) {
+			if (span > options.bitmap_max_bits) {
+				throw std::exception("Key range is too wide for a BITMAP prefilter.");
+			}
+			filter.words.resize((std::size_t)((span + 63) / 64));
+			for (const auto& key : sorted_keys) {
+				auto bit = (uint32_t)key - (uint32_t)filter.min_key;
+				filter.words[bit / 64] |= 1ull << (bit % 64);
+			}
+		}
+		else if (filter.kind == TablePrefilter::BLOOM) {
+			const uint64_t bits = (uint64_t)sorted_keys.size() * options.bloom_bits_per_key;
+			filter.log2_words = 1;
+			while (filter.log2_words < BLOOM_MAX_LOG2_WORDS && (64ull << filter.log2_words) < bits) {
+				filter.log2_words++;
+			}
+			filter.words.resize((std::size_t)1 << filter.log2_words);
+			for (const auto& key : sorted_keys) {
+				auto hash = bloom_hash(key);
+				filter.words[hash >> (64 - filter.log2_words)] |= bloom_mask(hash);
+			}
+		}
+		return filter;
+	}
+
+	bool may_contain(int32_t key) const noexcept {
+		if (kind == TablePrefilter::NONE) {
+			return true;
+		}
+		auto offset = (uint32_t)key - (uint32_t)min_key;
+		if (offset > (uint32_t)max_key - (uint32_t)min_key) {
+			return false;
+		}
+		if (kind == TablePrefilter::BITMAP) {
+			return (words[offset / 64] >> (offset % 64)) & 1;
+		}
+		if (kind == TablePrefilter::BLOOM) {
+			auto hash = bloom_hash(key);
+			auto mask = bloom_mask(hash);
+			return (words[hash >> (64 - log2_words)] & mask) == mask;
+		}
+		return true;
+	}
+};
+
 namespace CodegenTable {
 	struct ASM_context {
 		uint32_t global_label_counter;
@@ -68,7 +171,8 @@ namespace CodegenTable {
 
 	enum struct UsageType {
 		JUMP,
-		DEFERENCE
+		DEFERENCE,
+		ADDRESS // lea of a label, the definition marks the start of the data
 	};
 
 	struct LabelUsage {
@@ -190,13 +294,7 @@ namespace CodegenTable {
 		}
 	}
 
-	std::vector<Byte> codegen(JITableTree const* root) {
-		std::map<uint32_t, LabelDefinition> label_defintions = {}; // label counter -> defintion
-		std::vector<LabelUsage> label_usages = {};
-		ASM_context context = { .global_label_counter = 0, .global_return_counter = 0 };
-
-		std::vector<Byte> bytes = {};
-		codegen_impl(root, bytes, label_defintions, label_usages, context, 0, 0);
+	void resolve_labels(std::vector<Byte>& bytes, const std::map<uint32_t, LabelDefinition>& label_defintions, const std::vector<LabelUsage>& label_usages) {
 		Byte* ptr_no_offset = bytes.data();
 		for (const auto& usage : label_usages) {
 			Byte* bptr = ptr_no_offset + usage.start_offset;
@@ -206,7 +304,7 @@ namespace CodegenTable {
 				if (usage.type == UsageType::DEFERENCE) {
 					*ptr = def.start_offset - usage.start_offset - 8;
 				}
-				else if (usage.type == UsageType::JUMP) {
+				else if (usage.type == UsageType::JUMP || usage.type == UsageType::ADDRESS) {
 					*ptr = def.start_offset - usage.start_offset - 4;
 				}
 				else {
@@ -217,6 +315,208 @@ namespace CodegenTable {
 				throw std::exception("Could not find label definition.");
 			}
 		}
+	}
+
+	// Jumps to miss_label when the key in ecx is rejected, clobbers rax, rdx, r8 and r9
+	void codegen_prefilter(
+		const JITablePrefilter& prefilter,
+		std::vector<Byte>& bytes,
+		std::vector<LabelUsage>& label_usages,
+		uint32_t miss_label,
+		uint32_t data_label
+	) {
+		if (prefilter.kind == TablePrefilter::NONE) {
+			return;
+		}
+		// eax = ecx - min_key, anything outside of the range wraps above max_key - min_key
+		write_bytes(lea_eax_rcx_PLUS_MISSING_4_BYTES, bytes);
+		write_bytes<uint32_t>(0u - (uint32_t)prefilter.min_key, bytes);
+		write_bytes(cmp_eax_MISSING_4_BYTES, bytes);
+		write_bytes<uint32_t>((uint32_t)prefilter.max_key - (uint32_t)prefilter.min_key, bytes);
+		write_bytes(ja_0x00000000, bytes);
+		label_usages.push_back(LabelUsage{ .start_offset = bytes.size() - 4, .id = miss_label, .type = UsageType::JUMP });
+
+		if (prefilter.kind == TablePrefilter::BITMAP) {
+			write_bytes(mov_edx_eax, bytes);
+			write_bytes(shr_edx_MISSING_1_BYTE, bytes);
+			write_bytes<Byte>(6, bytes);
+			write_bytes(lea_r8_rip_PLUS_0x00000000, bytes);
+			label_usages.push_back(LabelUsage{ .start_offset = bytes.size() - 4, .id = data_label, .type = UsageType::ADDRESS });
+			write_bytes(mov_rdx_QWORD_PTR_r8_PLUS_rdx_TIMES_8, bytes);
+			write_bytes(bt_rdx_rax, bytes);
+			write_bytes(jae_0x00000000, bytes);
+			label_usages.push_back(LabelUsage{ .start_offset = bytes.size() - 4, .id = miss_label, .type = UsageType::JUMP });
+		}
+		else if (prefilter.kind == TablePrefilter::BLOOM) {
+			// rdx = hash, rax = filter word
+			write_bytes(mov_edx_ecx, bytes);
+			write_bytes(mov_rax_MISSING_8_BYTES, bytes);
+			write_bytes<uint64_t>(JITablePrefilter::BLOOM_MULTIPLIER, bytes);
+			write_bytes(imul_rdx_rax, bytes);
+			write_bytes(mov_rax_rdx, bytes);
+			write_bytes(shr_rax_MISSING_1_BYTE, bytes);
+			write_bytes<Byte>(64 - prefilter.log2_words, bytes);
+			write_bytes(lea_r8_rip_PLUS_0x00000000, bytes);
+			label_usages.push_back(LabelUsage{ .start_offset = bytes.size() - 4, .id = data_label, .type = UsageType::ADDRESS });
+			write_bytes(mov_rax_QWORD_PTR_r8_PLUS_rax_TIMES_8, bytes);
+			// r9 = mask, bts only looks at the low 6 bits of rdx
+			write_bytes(shr_rdx_MISSING_1_BYTE, bytes);
+			write_bytes<Byte>(JITablePrefilter::BLOOM_BIT_SHIFT, bytes);
+			write_bytes(xor_r9d_r9d, bytes);
+			for (int i = 0; i < 3; i++) {
+				if (i != 0) {
+					write_bytes(shr_rdx_MISSING_1_BYTE, bytes);
+					write_bytes<Byte>(6, bytes);
+				}
+				write_bytes(bts_r9_rdx, bytes);
+			}
+			// Miss if any bit of the mask is clear in the word
+			write_bytes(not_rax, bytes);
+			write_bytes(test_rax_r9, bytes);
+			write_bytes(jne_0x00000000, bytes);
+			label_usages.push_back(LabelUsage{ .start_offset = bytes.size() - 4, .id = miss_label, .type = UsageType::JUMP });
+		}
+	}
+
+	std::vector<Byte> codegen(JITableTree const* root, const JITablePrefilter& prefilter = {}) {
+		std::map<uint32_t, LabelDefinition> label_defintions = {}; // label counter -> defintion
+		std::vector<LabelUsage> label_usages = {};
+		ASM_context context = { .global_label_counter = 0, .global_return_counter = 0 };
+		const auto miss_label = context.global_label_counter++;
+		const auto data_label = context.global_label_counter++;
+
+		std::vector<Byte> bytes = {};
+		codegen_prefilter(prefilter, bytes, label_usages, miss_label, data_label);
+		if (root == nullptr) {
+			// Empty table, every key is a miss
+			write_bytes(xor_eax_eax, bytes);
+			write_bytes(ret, bytes);
+		}
+		else {
+			codegen_impl(root, bytes, label_defintions, label_usages, context, 0, 0);
+		}
+		if (prefilter.kind != TablePrefilter::NONE) {
+			label_defintions.insert({ miss_label, LabelDefinition{.start_offset = bytes.size() } });
+			write_bytes(xor_eax_eax, bytes);
+			write_bytes(ret, bytes);
+			while (bytes.size() % 8 != 0) {
+				write_bytes(int3, bytes);
+			}
+			label_defintions.insert({ data_label, LabelDefinition{.start_offset = bytes.size() } });
+			for (const auto& word : prefilter.words) {
+				write_bytes<uint64_t>(word, bytes);
+			}
+		}
+		resolve_labels(bytes, label_defintions, label_usages);
+		return bytes;
+	}
+
+	// Return sequences shared by every table compiled into the same code region,
+	// one "mov rax, value; ret" per distinct value and one for not found.
+	struct SharedStubs {
+		uint32_t not_found_label;
+		std::map<const void*, uint32_t> value_labels;
+	};
+
+	void codegen_shared_impl(
+		JITableTree const* node,
+		std::vector<Byte>& bytes,
+		std::map<uint32_t, LabelDefinition>& label_definitions,
+		std::vector<LabelUsage>& label_usages,
+		ASM_context& context,
+		SharedStubs& stubs
+	) {
+		// We receive the key through ecx
+		write_bytes(cmp_ecx_MISSING_4_BYTES, bytes);
+		write_bytes(node->key, bytes);
+
+		if (node->left != nullptr) {
+			auto greater_equal_label = context.global_label_counter++;
+			write_bytes(jge_0x00000000, bytes);
+			label_usages.push_back(LabelUsage{ .start_offset = bytes.size() - 4, .id = greater_equal_label, .type = UsageType::JUMP });
+
+			// ecx < node->key
+			codegen_shared_impl(node->left, bytes, label_definitions, label_usages, context, stubs);
+
+			// ecx >= node->key
+			label_definitions.insert({ greater_equal_label, LabelDefinition{.start_offset = bytes.size() } });
+		}
+		else {
+			// ecx < node->key, nothing exists here
+			write_bytes(jl_0x00000000, bytes);
+			label_usages.push_back(LabelUsage{ .start_offset = bytes.size() - 4, .id = stubs.not_found_label, .type = UsageType::JUMP });
+		}
+
+		// ecx == node->key
+		if (!stubs.value_labels.contains(node->value)) {
+			stubs.value_labels.insert({ node->value, context.global_label_counter++ });
+		}
+		write_bytes(je_0x00000000, bytes);
+		label_usages.push_back(LabelUsage{ .start_offset = bytes.size() - 4, .id = stubs.value_labels.at(node->value), .type = UsageType::JUMP });
+
+		// ecx > node->key
+		if (node->right != nullptr) {
+			codegen_shared_impl(node->right, bytes, label_definitions, label_usages, context, stubs);
+		}
+		else {
+			write_bytes(jmp_0x00000000, bytes);
+			label_usages.push_back(LabelUsage{ .start_offset = bytes.size() - 4, .id = stubs.not_found_label, .type = UsageType::JUMP });
+		}
+	}
+
+	// Single entry point taking (table_id, key) in ecx and edx. The table id goes through a jump table
+	// of offsets to every table's search tree, unknown ids and empty tables return nullptr.
+	std::vector<Byte> codegen_set(const std::vector<JITableTree const*>& roots) {
+		std::map<uint32_t, LabelDefinition> label_defintions = {}; // label counter -> defintion
+		std::vector<LabelUsage> label_usages = {};
+		ASM_context context = { .global_label_counter = 0, .global_return_counter = 0 };
+		const auto jump_table_label = context.global_label_counter++;
+		SharedStubs stubs = { .not_found_label = context.global_label_counter++, .value_labels = {} };
+
+		std::vector<Byte> bytes = {};
+		write_bytes(cmp_ecx_MISSING_4_BYTES, bytes);
+		write_bytes<uint32_t>((uint32_t)roots.size(), bytes);
+		write_bytes(jae_0x00000000, bytes);
+		label_usages.push_back(LabelUsage{ .start_offset = bytes.size() - 4, .id = stubs.not_found_label, .type = UsageType::JUMP });
+		write_bytes(mov_eax_ecx, bytes);
+		write_bytes(mov_ecx_edx, bytes);
+		write_bytes(lea_rdx_rip_PLUS_0x00000000, bytes);
+		label_usages.push_back(LabelUsage{ .start_offset = bytes.size() - 4, .id = jump_table_label, .type = UsageType::ADDRESS });
+		write_bytes(movsxd_rax_DWORD_PTR_rdx_PLUS_rax_TIMES_4, bytes);
+		write_bytes(add_rax_rdx, bytes);
+		write_bytes(jmp_rax, bytes);
+
+		std::vector<std::size_t> table_offsets = {};
+		for (const auto& root : roots) {
+			if (root == nullptr) {
+				table_offsets.push_back(SIZE_MAX);
+				continue;
+			}
+			table_offsets.push_back(bytes.size());
+			codegen_shared_impl(root, bytes, label_defintions, label_usages, context, stubs);
+		}
+
+		label_defintions.insert({ stubs.not_found_label, LabelDefinition{.start_offset = bytes.size() } });
+		const auto not_found_offset = bytes.size();
+		write_bytes(xor_eax_eax, bytes);
+		write_bytes(ret, bytes);
+		for (const auto& [value, label] : stubs.value_labels) {
+			label_defintions.insert({ label, LabelDefinition{.start_offset = bytes.size() } });
+			write_bytes(mov_rax_MISSING_8_BYTES, bytes);
+			write_bytes(value, bytes);
+			write_bytes(ret, bytes);
+		}
+
+		while (bytes.size() % 4 != 0) {
+			write_bytes(int3, bytes);
+		}
+		const auto jump_table_offset = bytes.size();
+		label_defintions.insert({ jump_table_label, LabelDefinition{.start_offset = jump_table_offset } });
+		for (const auto& offset : table_offsets) {
+			auto target = offset == SIZE_MAX ? not_found_offset : offset;
+			write_bytes<int32_t>((int32_t)((int64_t)target - (int64_t)jump_table_offset), bytes);
+		}
+		resolve_labels(bytes, label_defintions, label_usages);
 		return bytes;
 	}
 };
@@ -224,11 +524,40 @@ namespace CodegenTable {
 class ExeTable {
 	using FUNC_PTR = uint64_t(*)(int32_t);
 	void* memory;
+	JITablePrefilter filter;
+
+	void compile(JITableTree const* tree, const TableOptions& options) {
+		std::vector<int32_t> sorted_keys = {};
+		tree_keys(tree, sorted_keys);
+		filter = JITablePrefilter::build(sorted_keys, options);
+		auto bytes = CodegenTable::codegen(tree, filter);
+		memory = exec_memory_create(bytes);
+	}
+
+	static void tree_keys(JITableTree const* node, std::vector<int32_t>& keys) {
+		if (node == nullptr) {
+			return;
+		}
+		tree_keys(node->left, keys);
+		keys.push_back(node->key);
+		tree_keys(node->right, keys);
+	}
 public:
-	explicit ExeTable(const std::unordered_map<int32_t, void*>& basic_table) {
+	explicit ExeTable(const std::unordered_map<int32_t, void*>& basic_table, const TableOptions& options = {}) {
 		auto tree = build_table_tree(basic_table);
-		auto bytes = CodegenTable::codegen(tree);
-		memory = exec_memory_create(bytes);
+		compile(tree, options);
+		delete tree;
+	}
+	// The keys must be unique
+	explicit ExeTable(const std::vector<std::pair<int32_t, void*>>& kv_pairs, const TableOptions& options = {}) {
+		auto tree = build_table_tree(kv_pairs);
+		compile(tree, options);
+		delete tree;
+	}
+	// Same as above without copying the pairs
+	explicit ExeTable(std::vector<std::pair<int32_t, void*>>&& kv_pairs, const TableOptions& options = {}) {
+		auto tree = build_table_tree(std::move(kv_pairs));
+		compile(tree, options);
 		delete tree;
 	}
 	~ExeTable() {
@@ -238,6 +567,41 @@ public:
 		FUNC_PTR ptr = (FUNC_PTR)memory;
 		return ptr(key);
 	}
+	const JITablePrefilter& prefilter() const noexcept {
+		return filter;
+	}
+};
+
+// Many tables compiled into one code region behind a single (table_id, key) entry point,
+// so lookups across tables share one call target and one set of return stubs.
+class ExeTableSet {
+	using FUNC_PTR = uint64_t(*)(uint32_t, int32_t);
+	void* memory;
+	std::size_t table_count;
+public:
+	explicit ExeTableSet(const std::vector<std::unordered_map<int32_t, void*>>& basic_tables) : table_count{ basic_tables.size() } {
+		assert(basic_tables.size() <= UINT32_MAX);
+		// Owned so the trees already built are freed if a later table or codegen_set throws
+		std::vector<std::unique_ptr<const JITableTree>> trees = {};
+		std::vector<JITableTree const*> roots = {};
+		for (const auto& basic_table : basic_tables) {
+			trees.emplace_back(build_table_tree(basic_table));
+			roots.push_back(trees.back().get());
+		}
+		auto bytes = CodegenTable::codegen_set(roots);
+		memory = exec_memory_create(bytes);
+	}
+	~ExeTableSet() {
+		exec_memory_delete(memory);
+	}
+	std::size_t size() const noexcept {
+		return table_count;
+	}
+	// Returns 0 (nullptr) when table_id is out of range or the key is not in the table
+	uint64_t run(uint32_t table_id, int32_t key) const noexcept {
+		FUNC_PTR ptr = (FUNC_PTR)memory;
+		return ptr(table_id, key);
+	}
 };
 
 #endif // !_HEADER_JITABLE_HPP_
@@ -0,0 +1,207 @@
+#ifndef _HEADER_PIECEWISE_HPP_
+#define _HEADER_PIECEWISE_HPP_
+
+#include <vector>
+#include <map>
+#include <array>
+#include <limits>
+#include <algorithm>
+#include <cassert>
+#include "Byte.hpp"
+#include "ExecutableMemory.hpp"
+#include "BreakpointTree.hpp"
+
+// c[0] + c[1] * t + c[2] * t^2 + ... with t = x - origin. Keeping the origin at the start of the piece
+// keeps the coefficients small, which matters in float.
+struct PiecewisePolynomial {
+	float origin = 0.0f;
+	std::vector<float> coefficients;
+};
+
+// Piecewise linear interpolation through (xs[i], ys[i]), constant outside of [xs.front(), xs.back()].
+// Returns the xs.size() + 1 pieces ExePiecewise takes with xs as the breakpoints.
+std::vector<PiecewisePolynomial> piecewise_linear(const std::vector<float>& xs, const std::vector<float>& ys) {
+	if (xs.empty() || xs.size() != ys.size()) {
+		throw std::exception("Need as many ys as xs, and at least one of them.");
+	}
+	std::vector<PiecewisePolynomial> pieces = {};
+	pieces.push_back({ .origin = xs.front(), .coefficients = { ys.front() } });
+	for (std::size_t i = 1; i < xs.size(); i++) {
+		const auto slope = xs.at(i) > xs.at(i - 1) ? (ys.at(i) - ys.at(i - 1)) / (xs.at(i) - xs.at(i - 1)) : 0.0f;
+		pieces.push_back({ .origin = xs.at(i - 1), .coefficients = { ys.at(i - 1), slope } });
+	}
+	pieces.push_back({ .origin = xs.back(), .coefficients = { ys.back() } });
+	return pieces;
+}
+
+namespace CodegenPiecewise {
+	// Every row is the origin followed by up to 7 coefficients, 32 bytes
+	const uint32_t row_floats = 8;
+	const uint32_t max_degree = row_floats - 2;
+	using Row = std::array<float, row_floats>;
+
+	// The KARY_AVX_8 layout, except that each leaf is the rows of its 8 ranks followed by its
+	// 8 breakpoints, so the coefficients are in the lines next to the breakpoints that selected them.
+	// Leaf j holds the rows of ranks 8j + 1 to 8j + 8, the row of rank 0 comes before the first leaf.
+	CodegenIntervalKary::Layout build_layout(const std::vector<float>& breakpoints, const std::vector<Row>& rows) {
+		const uint32_t width = 8;
+		auto layout = CodegenIntervalKary::build_layout(breakpoints, width);
+		const auto leaf_start = layout.level_offsets.back() / sizeof(float);
+		const std::vector<float> leaves(layout.data.begin() + leaf_start, layout.data.end());
+		layout.data.resize(leaf_start);
+
+		Row padding = {};
+		padding.fill(std::numeric_limits<float>::quiet_NaN());
+		layout.data.insert(layout.data.end(), rows.front().begin(), rows.front().end());
+		layout.level_offsets.back() = layout.data.size() * sizeof(float);
+		for (std::size_t leaf = 0; leaf < leaves.size() / width; leaf++) {
+			for (std::size_t i = 1; i <= width; i++) {
+				const auto rank = leaf * width + i;
+				const auto& row = rank < rows.size() ? rows.at(rank) : padding;
+				layout.data.insert(layout.data.end(), row.begin(), row.end());
+			}
+			layout.data.insert(layout.data.end(), leaves.begin() + leaf * width, leaves.begin() + (leaf + 1) * width);
+		}
+		// A leaf is 8 rows and 8 breakpoints, 9 times the 32 bytes of an internal node
+		layout.leaf_scale = 9;
+		layout.leaf_key_offset = width * row_floats * (uint32_t)sizeof(float);
+		return layout;
+	}
+
+	// Replaces x in xmm0 by f(x). Clobbers rax, rcx, rdx, xmm1, ymm4 and ymm5.
+	void codegen_evaluate(
+		const CodegenIntervalKary::Layout& layout,
+		uint32_t degree,
+		uint32_t data_label,
+		std::vector<Byte>& bytes,
+		std::vector<CodegenInterval::LabelUsage>& label_usages
+	) {
+		CodegenIntervalKary::codegen_descend(layout, 0, data_label, bytes, label_usages);
+		write_bytes(vzeroupper, bytes);
+		// rcx + rdx + row is the row of the rank, eax is at least 1 except in the first leaf
+		write_bytes(shl_eax_MISSING_1_BYTE, bytes);
+		write_bytes<Byte>(5, bytes);
+		write_bytes(add_rdx_rax, bytes);
+		const uint32_t row = (uint32_t)layout.level_offsets.back() - row_floats * (uint32_t)sizeof(float);
+
+		// Horner's method, xmm0 = t and xmm1 = accumulator
+		write_bytes(subss_xmm0_DWORD_PTR_rcx_PLUS_rdx_PLUS_MISSING_4_BYTES, bytes);
+		write_bytes<uint32_t>(row, bytes);
+		write_bytes(movss_xmm1_DWORD_PTR_rcx_PLUS_rdx_PLUS_MISSING_4_BYTES, bytes);
+		write_bytes<uint32_t>(row + (1 + degree) * (uint32_t)sizeof(float), bytes);
+		for (uint32_t i = degree; i > 0; i--) {
+			write_bytes(mulss_xmm1_xmm0, bytes);
+			write_bytes(addss_xmm1_DWORD_PTR_rcx_PLUS_rdx_PLUS_MISSING_4_BYTES, bytes);
+			write_bytes<uint32_t>(row + i * (uint32_t)sizeof(float), bytes);
+		}
+		write_bytes(movaps_xmm0_xmm1, bytes);
+	}
+
+	// C ABI calling convention: values in rcx, results in rdx and count in r8. The evaluation is
+	// inlined in the loop, which is branchless, so the out of order core overlaps the cache misses
+	// of consecutive values.
+	void codegen_batch(
+		const CodegenIntervalKary::Layout& layout,
+		uint32_t degree,
+		uint32_t data_label,
+		std::vector<Byte>& bytes,
+		std::vector<CodegenInterval::LabelUsage>& label_usages,
+		std::map<uint32_t, CodegenInterval::LabelDefinition>& label_definitions,
+		uint32_t loop_label,
+		uint32_t done_label
+	) {
+		write_bytes(mov_r10_rcx, bytes);
+		write_bytes(mov_r11_rdx, bytes);
+		write_bytes(test_r8_r8, bytes);
+		write_bytes(je_0x00000000, bytes);
+		label_usages.push_back(CodegenInterval::LabelUsage{ .start_offset = bytes.size() - 4, .id = done_label, .type = CodegenInterval::UsageType::JUMP });
+
+		label_definitions.insert({ loop_label, CodegenInterval::LabelDefinition{.start_offset = bytes.size() } });
+		write_bytes(movss_xmm0_DWORD_PTR_r10, bytes);
+		codegen_evaluate(layout, degree, data_label, bytes, label_usages);
+		write_bytes(movss_DWORD_PTR_r11_xmm0, bytes);
+		write_bytes(add_r10_0x04, bytes);
+		write_bytes(add_r11_0x04, bytes);
+		write_bytes(dec_r8, bytes);
+		write_bytes(jne_0x00000000, bytes);
+		label_usages.push_back(CodegenInterval::LabelUsage{ .start_offset = bytes.size() - 4, .id = loop_label, .type = CodegenInterval::UsageType::JUMP });
+
+		label_definitions.insert({ done_label, CodegenInterval::LabelDefinition{.start_offset = bytes.size() } });
+		write_bytes(ret, bytes);
+	}
+
+	// C ABI calling convention: the scalar entry at offset 0 takes x in xmm0 and returns f(x) into xmm0,
+	// the batch entry is at batch_offset
+	std::vector<Byte> codegen(const std::vector<float>& breakpoints, const std::vector<Row>& rows, uint32_t degree, std::size_t& batch_offset) {
+		const uint32_t data_label = 0;
+		const uint32_t loop_label = 1;
+		const uint32_t done_label = 2;
+		const auto layout = build_layout(breakpoints, rows);
+
+		std::map<uint32_t, CodegenInterval::LabelDefinition> label_defintions = {};
+		std::vector<CodegenInterval::LabelUsage> label_usages = {};
+		std::vector<Byte> bytes = {};
+
+		codegen_evaluate(layout, degree, data_label, bytes, label_usages);
+		write_bytes(ret, bytes);
+		while (bytes.size() % 16 != 0) {
+			write_bytes(int3, bytes);
+		}
+		batch_offset = bytes.size();
+		codegen_batch(layout, degree, data_label, bytes, label_usages, label_defintions, loop_label, done_label);
+
+		CodegenIntervalKary::codegen_data(layout, data_label, bytes, label_defintions);
+		CodegenInterval::resolve_labels(bytes, label_defintions, label_usages);
+		return bytes;
+	}
+};
+
+// Evaluates a piecewise polynomial, the interval search and the coefficient loads in one call.
+// pieces[0] applies below breakpoints[0], pieces[i] on [breakpoints[i - 1], breakpoints[i]) and
+// pieces.back() from breakpoints.back() on. NaN falls into pieces[0]. Requires AVX2.
+class ExePiecewise {
+	using FUNC_PTR = float(*)(float);
+	using BATCH_PTR = void(*)(const float*, float*, std::size_t);
+	void* memory;
+	std::size_t batch_offset;
+public:
+	explicit ExePiecewise(const std::vector<float>& breakpoints, const std::vector<PiecewisePolynomial>& pieces) {
+		assert(breakpoints.size() >= 1);
+		assert(std::is_sorted(breakpoints.begin(), breakpoints.end()));
+		if (breakpoints.size() > INT32_MAX / 16) {
+			throw std::exception("Too many breakpoints.");
+		}
+		if (pieces.size() != breakpoints.size() + 1) {
+			throw std::exception("Need one more piece than breakpoints.");
+		}
+		// Same code as the KARY_AVX_8 search
+		kary_layout_width(IntervalSearchLayout::KARY_AVX_8);
+		uint32_t degree = 0;
+		std::vector<CodegenPiecewise::Row> rows = {};
+		rows.reserve(pieces.size());
+		for (const auto& piece : pieces) {
+			if (piece.coefficients.size() > CodegenPiecewise::max_degree + 1) {
+				throw std::exception("Polynomial degree is too high.");
+			}
+			CodegenPiecewise::Row row = { piece.origin };
+			std::copy(piece.coefficients.begin(), piece.coefficients.end(), row.begin() + 1);
+			rows.push_back(row);
+			degree = std::max(degree, (uint32_t)std::max<std::size_t>(piece.coefficients.size(), 1) - 1);
+		}
+		auto bytes = CodegenPiecewise::codegen(breakpoints, rows, degree, batch_offset);
+		memory = exec_memory_create(bytes);
+	}
+	~ExePiecewise() {
+		exec_memory_delete(memory);
+	}
+	float run(float value) const noexcept {
+		FUNC_PTR ptr = (FUNC_PTR)memory;
+		return ptr(value);
+	}
+	void run_batch(const float* values, float* results, std::size_t count) const noexcept {
+		BATCH_PTR ptr = (BATCH_PTR)((Byte*)memory + batch_offset);
+		ptr(values, results, count);
+	}
+};
+
+#endif // !_HEADER_PIECEWISE_HPP_
@@ -0,0 +1,120 @@
+#ifndef _HEADER_TIERED_HPP_
+#define _HEADER_TIERED_HPP_
+
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <chrono>
+#include "BreakpointTree.hpp"
+#include "JITable.hpp"
+
+// Answers straight away with interval_search_branchless over a copy of the breakpoints while
+// ExeIntervalSearch is compiled on a background thread, then switches to the compiled code.
+class TieredIntervalSearch {
+	const std::vector<float> intervals;
+	std::atomic<const ExeIntervalSearch*> compiled = nullptr;
+	std::shared_future<void> compilation;
+public:
+	explicit TieredIntervalSearch(const std::vector<float>& intervals, const IntervalSearchOptions& options = {}) : intervals{ intervals } {
+		assert(intervals.size() >= 1);
+		assert(intervals.size() <= INT32_MAX);
+		compilation = std::async(std::launch::async, [this, options] {
+			compiled.store(new ExeIntervalSearch(this->intervals, options), std::memory_order_release);
+		}).share();
+	}
+	~TieredIntervalSearch() {
+		compilation.wait();
+		delete compiled.load(std::memory_order_acquire);
+	}
+	TieredIntervalSearch(const TieredIntervalSearch&) = delete;
+	TieredIntervalSearch& operator=(const TieredIntervalSearch&) = delete;
+
+	bool is_compiled() const noexcept {
+		return compiled.load(std::memory_order_acquire) != nullptr;
+	}
+	// Blocks until the compiled code is in use, rethrows if compilation failed
+	void wait() const {
+		compilation.get();
+	}
+	// Returns true if the compiled code is in use before timeout runs out
+	template <typename Rep, typename Period>
+	bool wait_for(const std::chrono::duration<Rep, Period>& timeout) const {
+		return compilation.wait_for(timeout) == std::future_status::ready && is_compiled();
+	}
+	int32_t run(float value) const noexcept {
+		if (const auto jit = compiled.load(std::memory_order_acquire); jit != nullptr) {
+			return jit->run(value);
+		}
+		return interval_search_branchless(intervals, value);
+	}
+	void run_batch(const float* values, int32_t* results, std::size_t count) const noexcept {
+		if (const auto jit = compiled.load(std::memory_order_acquire); jit != nullptr) {
+			jit->run_batch(values, results, count);
+			return;
+		}
+		for (std::size_t i = 0; i < count; i++) {
+			results[i] = interval_search_branchless(intervals, values[i]);
+		}
+	}
+};
+
+// Answers straight away with a binary search over the sorted keys while ExeTable is compiled
+// on a background thread, then switches to the compiled code.
+class TieredTable {
+	std::vector<int32_t> keys;
+	std::vector<void*> values;
+	std::atomic<const ExeTable*> compiled = nullptr;
+	std::shared_future<void> compilation;
+public:
+	explicit TieredTable(const std::unordered_map<int32_t, void*>& basic_table, const TableOptions& options = {}) {
+		std::vector<std::pair<int32_t, void*>> kv_pairs(basic_table.begin(), basic_table.end());
+		std::sort(kv_pairs.begin(), kv_pairs.end());
+		keys.reserve(kv_pairs.size());
+		values.reserve(kv_pairs.size());
+		for (const auto& kv : kv_pairs) {
+			if (kv.second == nullptr) {
+				throw std::exception("Not allowed to have a value be nullptr");
+			}
+			keys.push_back(kv.first);
+			values.push_back(kv.second);
+		}
+		// The pairs are already sorted, ExeTable takes them over as they are
+		compilation = std::async(std::launch::async, [this, kv_pairs = std::move(kv_pairs), options]() mutable {
+			compiled.store(new ExeTable(std::move(kv_pairs), options), std::memory_order_release);
+		}).share();
+	}
+	~TieredTable() {
+		compilation.wait();
+		delete compiled.load(std::memory_order_acquire);
+	}
+	TieredTable(const TieredTable&) = delete;
+	TieredTable& operator=(const TieredTable&) = delete;
+
+	bool is_compiled() const noexcept {
+		return compiled.load(std::memory_order_acquire) != nullptr;
+	}
+	// Blocks until the compiled code is in use, rethrows if compilation failed
+	void wait() const {
+		compilation.get();
+	}
+	// Returns true if the compiled code is in use before timeout runs out
+	template <typename Rep, typename Period>
+	bool wait_for(const std::chrono::duration<Rep, Period>& timeout) const {
+		return compilation.wait_for(timeout) == std::future_status::ready && is_compiled();
+	}
+	uint64_t run(int32_t key) const noexcept {
+		if (const auto jit = compiled.load(std::memory_order_acquire); jit != nullptr) {
+			return jit->run(key);
+		}
+		auto iter = std::lower_bound(keys.begin(), keys.end(), key);
+		if (iter == keys.end() || *iter != key) {
+			return 0;
+		}
+		return (uint64_t)values[iter - keys.begin()];
+	}
+};
+
+#endif // !_HEADER_TIERED_HPP_
@@ -0,0 +1,188 @@
+#ifndef _HEADER_WORK_STEALING_POOL_HPP_
+#define _HEADER_WORK_STEALING_POOL_HPP_
+
+#define NOMINMAX
+#include <windows.h>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <exception>
+#include <memory>
+#include <algorithm>
+
+// Fixed set of worker threads running one parallel_for at a time. The indices are dealt out in
+// contiguous ranges, a worker takes from the front of its own range and once it is empty steals
+// from the back of the other workers, trying the workers on its own NUMA node first.
+class WorkStealingPool {
+	struct alignas(64) WorkerQueue {
+		std::mutex mutex;
+		std::deque<std::size_t> items;
+	};
+
+	using Task = std::function<void(std::size_t worker, std::size_t index)>;
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+	std::vector<uint32_t> numa_nodes; // worker -> NUMA node
+	std::vector<std::thread> threads;
+
+	std::mutex run_mutex; // Only one parallel_for at a time
+	std::mutex mutex;
+	std::condition_variable work_available;
+	std::condition_variable work_done;
+	uint64_t generation = 0;
+	std::size_t active_workers = 0;
+	bool stopping = false;
+	const Task* task = nullptr;
+	std::exception_ptr failure = nullptr;
+
+	bool pop_own(std::size_t worker, std::size_t& index) {
+		auto& queue = *queues.at(worker);
+		std::lock_guard lock(queue.mutex);
+		if (queue.items.empty()) {
+			return false;
+		}
+		index = queue.items.front();
+		queue.items.pop_front();
+		return true;
+	}
+
+	bool steal_from(std::size_t victim, std::size_t& index) {
+		auto& queue = *queues.at(victim);
+		std::lock_guard lock(queue.mutex);
+		if (queue.items.empty()) {
+			return false;
+		}
+		index = queue.items.back();
+		queue.items.pop_back();
+		return true;
+	}
+
+	bool steal(std::size_t worker, std::size_t& index) {
+		const auto count = queues.size();
+		for (bool same_node : { true, false }) {
+			for (std::size_t offset = 1; offset < count; offset++) {
+				auto victim = (worker + offset) % count;
+				if ((numa_nodes.at(victim) == numa_nodes.at(worker)) != same_node) {
+					continue;
+				}
+				if (steal_from(victim, index)) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	void pin_to_numa_node(std::size_t worker) {
+		GROUP_AFFINITY affinity = {};
+		if (GetNumaNodeProcessorMaskEx((USHORT)numa_nodes.at(worker), &affinity) && affinity.Mask != 0) {
+			SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr);
+		}
+	}
+
+	void worker_main(std::size_t worker, bool numa_aware) {
+		if (numa_aware) {
+			pin_to_numa_node(worker);
+		}
+		uint64_t seen_generation = 0;
+		while (true) {
+			{
+				std::unique_lock lock(mutex);
+				work_available.wait(lock, [&] { return stopping || generation != seen_generation; });
+				if (stopping) {
+					return;
+				}
+				seen_generation = generation;
+			}
+			std::size_t index = 0;
+			while (pop_own(worker, index) || steal(worker, index)) {
+				try {
+					(*task)(worker, index);
+				}
+				catch (...) {
+					std::lock_guard lock(mutex);
+					if (failure == nullptr) {
+						failure = std::current_exception();
+					}
+				}
+			}
+			{
+				std::lock_guard lock(mutex);
+				if (--active_workers == 0) {
+					work_done.notify_all();
+				}
+			}
+		}
+	}
+
+public:
+	explicit WorkStealingPool(std::size_t worker_count = std::thread::hardware_concurrency(), bool numa_aware = true) {
+		worker_count = std::max<std::size_t>(worker_count, 1);
+		ULONG highest_node = 0;
+		if (!numa_aware || !GetNumaHighestNodeNumber(&highest_node)) {
+			highest_node = 0;
+		}
+		const std::size_t node_count = (std::size_t)highest_node + 1;
+		for (std::size_t worker = 0; worker < worker_count; worker++) {
+			queues.push_back(std::make_unique<WorkerQueue>());
+			// Neighbouring workers share a node, so the contiguous ranges they are dealt stay on one node
+			numa_nodes.push_back((uint32_t)(worker * node_count / worker_count));
+		}
+		for (std::size_t worker = 0; worker < worker_count; worker++) {
+			threads.emplace_back(&WorkStealingPool::worker_main, this, worker, numa_aware);
+		}
+	}
+	~WorkStealingPool() {
+		{
+			std::lock_guard lock(mutex);
+			stopping = true;
+		}
+		work_available.notify_all();
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+	std::size_t worker_count() const noexcept {
+		return queues.size();
+	}
+	uint32_t numa_node(std::size_t worker) const noexcept {
+		return numa_nodes.at(worker);
+	}
+
+	// Runs task(worker, index) for every index in [0, count) and blocks until all of them are done.
+	// Rethrows the first exception thrown by a task.
+	void parallel_for(std::size_t count, const Task& parallel_task) {
+		std::lock_guard run_lock(run_mutex);
+		const auto workers = queues.size();
+		for (std::size_t worker = 0; worker < workers; worker++) {
+			auto& queue = *queues.at(worker);
+			std::lock_guard lock(queue.mutex);
+			for (std::size_t index = count * worker / workers; index < count * (worker + 1) / workers; index++) {
+				queue.items.push_back(index);
+			}
+		}
+		std::exception_ptr result = nullptr;
+		{
+			std::unique_lock lock(mutex);
+			task = &parallel_task;
+			failure = nullptr;
+			active_workers = workers;
+			generation++;
+			work_available.notify_all();
+			work_done.wait(lock, [&] { return active_workers == 0; });
+			task = nullptr;
+			result = failure;
+		}
+		if (result != nullptr) {
+			std::rethrow_exception(result);
+		}
+	}
+};
+
+#endif // !_HEADER_WORK_STEALING_POOL_HPP_
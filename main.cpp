@@ -3,8 +3,18 @@
 #include <map>
 #include <chrono>
 #include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <array>
+#include <string>
 #include "BreakpointTree.hpp"
 #include "JITable.hpp"
+#include "IntervalPipeline.hpp"
+#include "IntervalAggregate.hpp"
+#include "Tiered.hpp"
+#include "GridSearch.hpp"
+#include "JITStringTable.hpp"
+#include "Piecewise.hpp"
 #include "Byte.hpp"
 #include "ExecutableMemory.hpp"
 
@@ -42,15 +52,21 @@ void test() {
 	};
 
 	auto jit = ExeIntervalSearch(x_values);
+	auto jit_kary = ExeIntervalSearch(x_values, { .layout = IntervalSearchLayout::KARY_AVX_8 });
+	auto jit_branchless = ExeIntervalSearch(x_values, { .branchless_levels = 2 });
 
 	for (const auto& v : checkpoints) {
 		auto a = interval_search_linear(x_values, v);
 		auto b = interval_search_binary(x_values, v);
 		auto c = jit.run(v);
+		auto d = jit_kary.run(v);
+		auto e = jit_branchless.run(v);
 		std::cout
 			<< a << ", "
 			<< b << ", "
-			<< c
+			<< c << ", "
+			<< d << ", "
+			<< e
 			<< "\n";
 	}
 }
@@ -82,6 +98,7 @@ int main_jitree() {
 	auto t0 = std::chrono::high_resolution_clock::now();
 	auto jit = ExeIntervalSearch(x_values);
 	auto t1 = std::chrono::high_resolution_clock::now();
+	auto jit_kary = ExeIntervalSearch(x_values, { .layout = IntervalSearchLayout::KARY_AVX_8 });
 
 	// The intervals are [lower_bound, upper_bound)
 
@@ -105,6 +122,7 @@ int main_jitree() {
 	bool disable_linear = true;
 	bool disable_binary = false;
 	bool disable_jit = false;
+	bool disable_jit_kary = false;
 	bool print_step = false;
 	int32_t radix = 100'000;
 
@@ -140,6 +158,16 @@ int main_jitree() {
 		}
 	}
 	auto t5 = std::chrono::high_resolution_clock::now();
+	if (!disable_jit_kary) {
+		for (int32_t i = 0; i < steps; i++) {
+			if (print_step && i % radix == 0) {
+				std::cout << "JIT k-ary: (" << i + 1 << "/" << steps << ")\n";
+			}
+			float f = increment * i + lower_bound;
+			volatile int32_t index = jit_kary.run(f);
+		}
+	}
+	auto t6 = std::chrono::high_resolution_clock::now();
 
 	if (!disable_linear) {
 		std::cout << "Linear Search: " << std::chrono::duration_cast<std::chrono::milliseconds>(t3 - t2) << "\n";
@@ -152,10 +180,136 @@ int main_jitree() {
 			<< ", compilation: " << std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0) 
 			<< " or " << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0) << "\n";
 	}
+	if (!disable_jit_kary) {
+		std::cout << "JIT k-ary (AVX2, 8 per node): " << std::chrono::duration_cast<std::chrono::milliseconds>(t6 - t5) << "\n";
+	}
 	
 	return 0;
 }
 
+constexpr std::array<float, 4'096> static_breakpoints = [] {
+	std::array<float, 4'096> breakpoints = {};
+	for (std::size_t i = 0; i < breakpoints.size(); i++) {
+		breakpoints[i] = (float)i;
+	}
+	return breakpoints;
+}();
+static_assert(interval_search_static<static_breakpoints>(-0.5f) == -1);
+static_assert(interval_search_static<static_breakpoints>(10.5f) == 10);
+static_assert(interval_search_static<static_breakpoints>(4'095.0f) == -1);
+
+int main_static() {
+	std::vector<float> x_values(static_breakpoints.begin(), static_breakpoints.end());
+	auto t0 = std::chrono::high_resolution_clock::now();
+	auto jit = ExeIntervalSearch(x_values);
+	auto t1 = std::chrono::high_resolution_clock::now();
+	auto jit_kary = ExeIntervalSearch(x_values, { .layout = IntervalSearchLayout::KARY_AVX_8 });
+
+	float margin = 10.0f;
+	int32_t steps = 99'999'999;
+	float lower_bound = x_values.front() - margin;
+	float upper_bound = x_values.back() + margin;
+	float increment = (upper_bound - lower_bound) / steps;
+
+	auto t2 = std::chrono::high_resolution_clock::now();
+	for (int32_t i = 0; i < steps; i++) {
+		float f = increment * i + lower_bound;
+		volatile int32_t index = interval_search_static<static_breakpoints>(f);
+	}
+	auto t3 = std::chrono::high_resolution_clock::now();
+	for (int32_t i = 0; i < steps; i++) {
+		float f = increment * i + lower_bound;
+		volatile int32_t index = jit.run(f);
+	}
+	auto t4 = std::chrono::high_resolution_clock::now();
+	for (int32_t i = 0; i < steps; i++) {
+		float f = increment * i + lower_bound;
+		volatile int32_t index = jit_kary.run(f);
+	}
+	auto t5 = std::chrono::high_resolution_clock::now();
+	for (int32_t i = 0; i < steps; i++) {
+		float f = increment * i + lower_bound;
+		volatile int32_t index = interval_search_binary(x_values, f);
+	}
+	auto t6 = std::chrono::high_resolution_clock::now();
+
+	std::cout
+		<< "Breakpoints: " << static_breakpoints.size() << "\n"
+		<< "Static (constexpr): " << std::chrono::duration_cast<std::chrono::milliseconds>(t3 - t2) << ", compilation: none\n"
+		<< "JIT: " << std::chrono::duration_cast<std::chrono::milliseconds>(t4 - t3)
+		<< ", compilation: " << std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0) << "\n"
+		<< "JIT k-ary (AVX2, 8 per node): " << std::chrono::duration_cast<std::chrono::milliseconds>(t5 - t4) << "\n"
+		<< "Binary Search: " << std::chrono::duration_cast<std::chrono::milliseconds>(t6 - t5) << "\n";
+
+	return 0;
+}
+
+int main_grid() {
+	std::vector<float> prices = {};
+	std::vector<float> sizes = {};
+	for (std::size_t i = 0; i < 2'000; i++) {
+		prices.push_back((float)i * 0.25f);
+	}
+	for (std::size_t i = 0; i < 500; i++) {
+		sizes.push_back((float)(i * i));
+	}
+	auto jit_price = ExeIntervalSearch(prices, { .layout = IntervalSearchLayout::KARY_AVX_8 });
+	auto jit_size = ExeIntervalSearch(sizes, { .layout = IntervalSearchLayout::KARY_AVX_8 });
+	auto jit_grid = ExeGridSearch({ prices, sizes });
+
+	std::size_t point_count = 50'000'000;
+	std::vector<float> price_column(point_count);
+	std::vector<float> size_column(point_count);
+	for (std::size_t i = 0; i < point_count; i++) {
+		price_column[i] = (float)((i * 2'654'435'761u) % 2'010) * 0.25f - 1.0f;
+		size_column[i] = (float)((i * 40'503u) % 250'000);
+	}
+	std::vector<int32_t> expected(point_count);
+	std::vector<int32_t> grid_cells(point_count);
+	std::vector<int32_t> cells(point_count);
+
+	// Two lookups combined by hand
+	auto t0 = std::chrono::high_resolution_clock::now();
+	int32_t size_cells = (int32_t)sizes.size() - 1;
+	for (std::size_t i = 0; i < point_count; i++) {
+		int32_t price_index = jit_price.run(price_column[i]);
+		int32_t size_index = jit_size.run(size_column[i]);
+		expected[i] = (price_index < 0 || size_index < 0) ? -1 : price_index * size_cells + size_index;
+	}
+	auto t1 = std::chrono::high_resolution_clock::now();
+	for (std::size_t i = 0; i < point_count; i++) {
+		grid_cells[i] = jit_grid.run(price_column[i], size_column[i]);
+	}
+	auto t2 = std::chrono::high_resolution_clock::now();
+	const float* columns[] = { price_column.data(), size_column.data() };
+	jit_grid.run_batch(columns, cells.data(), point_count);
+	auto t3 = std::chrono::high_resolution_clock::now();
+	const bool grid_match = grid_cells == expected && cells == expected;
+
+	std::cout
+		<< "Points: " << point_count << ", cells: " << (prices.size() - 1) * (sizes.size() - 1) << "\n"
+		<< "2 x ExeIntervalSearch: " << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0) << "\n"
+		<< "ExeGridSearch: " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1) << "\n"
+		<< "ExeGridSearch, batch: " << std::chrono::duration_cast<std::chrono::milliseconds>(t3 - t2) << "\n"
+		<< "cells match: " << grid_match << "\n";
+
+	if (IsProcessorFeaturePresent(PF_AVX512F_INSTRUCTIONS_AVAILABLE)) {
+		auto jit_grid_avx512 = ExeGridSearch({ prices, sizes }, { .layout = IntervalSearchLayout::KARY_AVX512_16 });
+		auto t4 = std::chrono::high_resolution_clock::now();
+		jit_grid_avx512.run_batch(columns, cells.data(), point_count);
+		auto t5 = std::chrono::high_resolution_clock::now();
+		bool avx512_match = cells == expected;
+		for (std::size_t i = 0; i < point_count; i += 997) {
+			avx512_match &= jit_grid_avx512.run(price_column[i], size_column[i]) == expected[i];
+		}
+		std::cout
+			<< "ExeGridSearch AVX-512, batch: " << std::chrono::duration_cast<std::chrono::milliseconds>(t5 - t4) << "\n"
+			<< "AVX-512 cells match: " << avx512_match << "\n";
+	}
+
+	return 0;
+}
+
 int main_jitable() {
 	std::unordered_map<int32_t, void*> table_std = {};
 	boost::unordered_map<int32_t, void*> table_boost = {};
@@ -179,6 +333,7 @@ int main_jitable() {
 	auto t0 = std::chrono::high_resolution_clock::now();
 	auto jit = ExeTable(table_std);
 	auto t1 = std::chrono::high_resolution_clock::now();
+	auto jit_bloom = ExeTable(table_std, { .prefilter = TablePrefilter::BLOOM });
 
 	auto t2 = std::chrono::high_resolution_clock::now();
 	for (int32_t i = start_point; i <= end_point; i += test_step) {
@@ -197,6 +352,20 @@ int main_jitable() {
 		volatile bool index = table_gtl.find(i) != table_gtl.end();
 	}
 	auto t6 = std::chrono::high_resolution_clock::now();
+	for (int32_t i = start_point; i <= end_point; i += test_step) {
+		volatile bool index = jit_bloom.run(i);
+	}
+	auto t7 = std::chrono::high_resolution_clock::now();
+
+	// How many of the misses the prefilter answers on its own, on a sample of the probes
+	uint64_t sampled_misses = 0;
+	uint64_t sampled_rejected = 0;
+	for (int32_t i = start_point; i <= end_point - 997; i += 997) {
+		if (table_std.find(i) == table_std.end()) {
+			sampled_misses++;
+			sampled_rejected += !jit_bloom.prefilter().may_contain(i);
+		}
+	}
 
 	std::cout
 		<< "Interval: [" << start_point << ", " << end_point << "], step ratio: " << test_step << "/" << build_step << ", entries: " << table_std.size() << "\n"
@@ -205,7 +374,383 @@ int main_jitable() {
 		<< ", compilation: " << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0) 
 		<< ", total: " << std::chrono::duration_cast<std::chrono::milliseconds>(t4 - t3 + t1 - t0) << "\n"
 		<< "boost: " << std::chrono::duration_cast<std::chrono::milliseconds>(t5 - t4) << "\n"
-		<< "gtl: " << std::chrono::duration_cast<std::chrono::milliseconds>(t6 - t5) << "\n";
+		<< "gtl: " << std::chrono::duration_cast<std::chrono::milliseconds>(t6 - t5) << "\n"
+		<< "jit + bloom prefilter: " << std::chrono::duration_cast<std::chrono::milliseconds>(t7 - t6)
+		<< ", misses rejected by the prefilter: " << 100.0 * sampled_rejected / std::max<uint64_t>(sampled_misses, 1) << "%\n";
+
+	return 0;
+}
+
+int main_jitable_set() {
+	std::size_t tenant_count = 300;
+	int32_t keys_per_tenant = 2'000;
+	int32_t build_step = 1'000;
+	std::vector<std::unordered_map<int32_t, void*>> tables_std(tenant_count);
+	// The last tenant has no keys, so its lookups go through the stub of an empty table
+	for (std::size_t tenant = 0; tenant + 1 < tenant_count; tenant++) {
+		for (int32_t i = 1; i <= keys_per_tenant; i++) {
+			auto key = i * build_step + (int32_t)tenant;
+			tables_std[tenant].insert({ key, (void*)(std::size_t)key });
+		}
+	}
+
+	auto t0 = std::chrono::high_resolution_clock::now();
+	std::vector<std::unique_ptr<ExeTable>> jit_tables = {};
+	for (const auto& table : tables_std) {
+		jit_tables.push_back(std::make_unique<ExeTable>(table));
+	}
+	auto t1 = std::chrono::high_resolution_clock::now();
+	auto jit_set = ExeTableSet(tables_std);
+	auto t2 = std::chrono::high_resolution_clock::now();
+
+	// Lookups hop from tenant to tenant like requests from many tenants would
+	int32_t probes = 50'000'000;
+	auto tenant_of = [&](int32_t i) {
+		return (uint32_t)(((uint64_t)i * 2'654'435'761u) % tenant_count);
+	};
+	auto key_of = [&](int32_t i) {
+		return (i % keys_per_tenant + 1) * build_step + (int32_t)tenant_of(i) + (i % 2);
+	};
+	auto t3 = std::chrono::high_resolution_clock::now();
+	for (int32_t i = 0; i < probes; i++) {
+		const auto& table = tables_std[tenant_of(i)];
+		volatile bool found = table.find(key_of(i)) != table.end();
+	}
+	auto t4 = std::chrono::high_resolution_clock::now();
+	for (int32_t i = 0; i < probes; i++) {
+		volatile uint64_t value = jit_tables[tenant_of(i)]->run(key_of(i));
+	}
+	auto t5 = std::chrono::high_resolution_clock::now();
+	for (int32_t i = 0; i < probes; i++) {
+		volatile uint64_t value = jit_set.run(tenant_of(i), key_of(i));
+	}
+	auto t6 = std::chrono::high_resolution_clock::now();
+
+	// Every tenant plus unknown ids, with hits and misses on both sides of every key
+	bool results_match = true;
+	for (uint32_t tenant = 0; tenant < tenant_count + 2; tenant++) {
+		const auto table_id = tenant <= tenant_count ? tenant : UINT32_MAX;
+		for (int32_t i = 0; i <= keys_per_tenant + 1; i++) {
+			for (int32_t offset = -1; offset <= 1; offset++) {
+				const auto key = i * build_step + (int32_t)tenant + offset;
+				uint64_t expected = 0;
+				if (table_id < tenant_count) {
+					const auto& table = tables_std[table_id];
+					const auto iter = table.find(key);
+					expected = iter == table.end() ? 0 : (uint64_t)iter->second;
+					results_match &= jit_tables[table_id]->run(key) == expected;
+				}
+				results_match &= jit_set.run(table_id, key) == expected;
+			}
+		}
+	}
+
+	std::cout
+		<< "Tenants: " << tenant_count << ", entries per tenant: " << keys_per_tenant << ", probes: " << probes << "\n"
+		<< "unordered_map per tenant: " << std::chrono::duration_cast<std::chrono::milliseconds>(t4 - t3) << "\n"
+		<< "ExeTable per tenant: " << std::chrono::duration_cast<std::chrono::milliseconds>(t5 - t4)
+		<< ", compilation: " << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0) << "\n"
+		<< "ExeTableSet: " << std::chrono::duration_cast<std::chrono::milliseconds>(t6 - t5)
+		<< ", compilation: " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1) << "\n"
+		<< "results match: " << results_match << "\n";
+
+	return 0;
+}
+
+int main_jitstring() {
+	// Symbol like keys of 1 to 24 characters, e.g. "AB3.X", "QZ_L0K9ABZ"
+	const std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789._";
+	std::size_t entry_count = 500;
+	std::vector<std::string> keys = {};
+	uint64_t state = 88'172'645'463'325'252ull;
+	auto next_random = [&]() {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	};
+	std::unordered_map<std::string, void*> table_std = {};
+	boost::unordered_map<std::string, void*> table_boost = {};
+	gtl::flat_hash_map<std::string, void*> table_gtl = {};
+	while (table_std.size() < entry_count) {
+		std::string key(next_random() % 24 + 1, ' ');
+		for (auto& c : key) {
+			c = alphabet[next_random() % alphabet.size()];
+		}
+		if (table_std.insert({ key, (void*)(table_std.size() + 1) }).second) {
+			table_boost.insert({ key, (void*)table_std.size() });
+			table_gtl.insert({ key, (void*)table_std.size() });
+			keys.push_back(key);
+		}
+	}
+	// Half of the probes are hits, the other half differ from a key by their last character
+	std::vector<std::string> probes = {};
+	for (std::size_t i = 0; i < 2'000'000; i++) {
+		auto key = keys[next_random() % keys.size()];
+		if (i % 2 == 1) {
+			key.back() = '#';
+		}
+		probes.push_back(key);
+	}
+
+	auto t0 = std::chrono::high_resolution_clock::now();
+	auto jit = ExeStringTable(table_std);
+	auto t1 = std::chrono::high_resolution_clock::now();
+	for (std::size_t repeat = 0; repeat < 10; repeat++) {
+		for (const auto& probe : probes) {
+			volatile bool found = table_std.find(probe) != table_std.end();
+		}
+	}
+	auto t2 = std::chrono::high_resolution_clock::now();
+	for (std::size_t repeat = 0; repeat < 10; repeat++) {
+		for (const auto& probe : probes) {
+			volatile bool found = jit.run(probe);
+		}
+	}
+	auto t3 = std::chrono::high_resolution_clock::now();
+	for (std::size_t repeat = 0; repeat < 10; repeat++) {
+		for (const auto& probe : probes) {
+			volatile bool found = table_boost.find(probe) != table_boost.end();
+		}
+	}
+	auto t4 = std::chrono::high_resolution_clock::now();
+	for (std::size_t repeat = 0; repeat < 10; repeat++) {
+		for (const auto& probe : probes) {
+			volatile bool found = table_gtl.find(probe) != table_gtl.end();
+		}
+	}
+	auto t5 = std::chrono::high_resolution_clock::now();
+
+	bool results_match = true;
+	for (const auto& probe : probes) {
+		const auto iter = table_std.find(probe);
+		results_match &= jit.run(probe) == (iter == table_std.end() ? 0 : (uint64_t)iter->second);
+	}
+
+	std::cout
+		<< "Entries: " << table_std.size() << ", probes: " << 10 * probes.size() << "\n"
+		<< "unordered_map: " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1) << "\n"
+		<< "jit: " << std::chrono::duration_cast<std::chrono::milliseconds>(t3 - t2)
+		<< ", compilation: " << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0) << "\n"
+		<< "boost: " << std::chrono::duration_cast<std::chrono::milliseconds>(t4 - t3) << "\n"
+		<< "gtl: " << std::chrono::duration_cast<std::chrono::milliseconds>(t5 - t4) << "\n"
+		<< "results match: " << results_match << "\n";
+
+	return 0;
+}
+
+int main_tiered() {
+	std::vector<float> x_values = {};
+	for (std::size_t i = 0; i < 1'000'000; i++) {
+		x_values.push_back((float)i);
+	}
+
+	// Time until the first query can be answered
+	auto t0 = std::chrono::high_resolution_clock::now();
+	auto jit = ExeIntervalSearch(x_values);
+	volatile int32_t first_jit = jit.run(500'000.5f);
+	auto t1 = std::chrono::high_resolution_clock::now();
+	auto tiered = TieredIntervalSearch(x_values);
+	volatile int32_t first_tiered = tiered.run(500'000.5f);
+	auto t2 = std::chrono::high_resolution_clock::now();
+
+	// Keep serving queries while the compilation runs
+	int32_t interpreted = 0;
+	while (!tiered.is_compiled()) {
+		float f = (float)(interpreted % 1'000'020) - 10.0f;
+		volatile int32_t index = tiered.run(f);
+		interpreted++;
+	}
+	auto t3 = std::chrono::high_resolution_clock::now();
+
+	std::cout
+		<< "ExeIntervalSearch, first answer after: " << std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0) << "\n"
+		<< "TieredIntervalSearch, first answer after: " << std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1) << "\n"
+		<< "TieredIntervalSearch, switched to JIT after: " << std::chrono::duration_cast<std::chrono::milliseconds>(t3 - t1)
+		<< ", queries answered before: " << interpreted << "\n";
+
+	return 0;
+}
+
+int main_pipeline() {
+	std::vector<float> x_values = {};
+	for (std::size_t i = 0; i < 1'000'000; i++) {
+		x_values.push_back((float)i);
+	}
+	auto jit = ExeIntervalSearch(x_values, { .layout = IntervalSearchLayout::KARY_AVX_8 });
+
+	// 256MiB of values scattered over the breakpoints
+	std::size_t value_count = 64 * 1024 * 1024;
+	std::vector<float> values(value_count);
+	for (std::size_t i = 0; i < value_count; i++) {
+		values[i] = (float)((i * 2'654'435'761u) % 1'000'020) - 10.0f;
+	}
+	std::vector<int32_t> results(value_count);
+	// Not initialized, so the workers' writes are the first touch and place the pages on their NUMA nodes
+	std::unique_ptr<int32_t[]> pipeline_results(new int32_t[value_count]);
+	WorkStealingPool pool = WorkStealingPool();
+
+	std::string input_path = "pipeline_input.bin";
+	std::string output_path = "pipeline_output.bin";
+	{
+		auto input_file = MappedFile(input_path, value_count * sizeof(float));
+		std::copy(values.begin(), values.end(), input_file.as_span<float>().begin());
+	}
+
+	auto t0 = std::chrono::high_resolution_clock::now();
+	jit.run_batch(values.data(), results.data(), value_count);
+	auto t1 = std::chrono::high_resolution_clock::now();
+	pipeline_classify(jit, values, std::span<int32_t>(pipeline_results.get(), value_count), pool);
+	auto t2 = std::chrono::high_resolution_clock::now();
+	pipeline_classify_file(jit, input_path, output_path, pool);
+	auto t3 = std::chrono::high_resolution_clock::now();
+
+	// Throughput of the input side, in GB/s
+	auto throughput = [&](auto duration) {
+		return (double)(value_count * sizeof(float)) / std::chrono::duration<double>(duration).count() / 1e9;
+	};
+	std::cout
+		<< "Values: " << value_count << ", workers: " << pool.worker_count() << "\n"
+		<< "run_batch, 1 thread: " << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0) << ", " << throughput(t1 - t0) << " GB/s\n"
+		<< "pipeline, memory: " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1) << ", " << throughput(t2 - t1) << " GB/s\n"
+		<< "pipeline, mapped file: " << std::chrono::duration_cast<std::chrono::milliseconds>(t3 - t2) << ", " << throughput(t3 - t2) << " GB/s\n";
+
+	std::filesystem::remove(input_path);
+	std::filesystem::remove(output_path);
+	return 0;
+}
+
+int main_aggregate() {
+	std::vector<float> x_values = {};
+	for (std::size_t i = 0; i < 1'000; i++) {
+		x_values.push_back((float)i);
+	}
+	auto jit = ExeIntervalAggregate(x_values, { .layout = IntervalSearchLayout::KARY_AVX_8 });
+
+	std::size_t value_count = 64 * 1024 * 1024;
+	std::vector<float> values(value_count);
+	std::vector<float> weights(value_count);
+	for (std::size_t i = 0; i < value_count; i++) {
+		values[i] = (float)((i * 2'654'435'761u) % 1'020) - 10.0f;
+		weights[i] = (float)(i % 7);
+	}
+	WorkStealingPool pool = WorkStealingPool();
+
+	// Bucketize first, then a second pass over the indices, once for each kind of result
+	std::vector<int32_t> indices(value_count);
+	auto t0 = std::chrono::high_resolution_clock::now();
+	for (std::size_t i = 0; i < value_count; i++) {
+		indices[i] = interval_search_binary(x_values, values[i]);
+	}
+	std::vector<uint64_t> counts_binary(jit.slot_count());
+	for (std::size_t i = 0; i < value_count; i++) {
+		counts_binary[indices[i] + 1]++;
+	}
+	auto t1 = std::chrono::high_resolution_clock::now();
+	for (std::size_t i = 0; i < value_count; i++) {
+		indices[i] = interval_search_binary(x_values, values[i]);
+	}
+	std::vector<double> sums_binary(jit.slot_count());
+	for (std::size_t i = 0; i < value_count; i++) {
+		sums_binary[indices[i] + 1] += weights[i];
+	}
+	auto t2 = std::chrono::high_resolution_clock::now();
+	std::vector<uint64_t> counts_fused(jit.slot_count());
+	jit.histogram(values.data(), value_count, counts_fused.data());
+	auto t3 = std::chrono::high_resolution_clock::now();
+	std::vector<double> sums_fused(jit.slot_count());
+	jit.sum(values.data(), weights.data(), value_count, sums_fused.data());
+	auto t4 = std::chrono::high_resolution_clock::now();
+	auto counts_parallel = jit.histogram(values, pool);
+	auto t5 = std::chrono::high_resolution_clock::now();
+	auto sums_parallel = jit.sum(values, weights, pool);
+	auto t6 = std::chrono::high_resolution_clock::now();
+
+	// The weights are small integers, so every partial sum is exact and the order of the additions does not matter
+	std::cout
+		<< "Values: " << value_count << ", intervals: " << x_values.size() - 1 << ", workers: " << pool.worker_count() << "\n"
+		<< "binary search + histogram loop: " << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0) << "\n"
+		<< "binary search + sum loop: " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1) << "\n"
+		<< "fused histogram: " << std::chrono::duration_cast<std::chrono::milliseconds>(t3 - t2) << "\n"
+		<< "fused sum: " << std::chrono::duration_cast<std::chrono::milliseconds>(t4 - t3) << "\n"
+		<< "fused histogram, pool: " << std::chrono::duration_cast<std::chrono::milliseconds>(t5 - t4) << "\n"
+		<< "fused sum, pool: " << std::chrono::duration_cast<std::chrono::milliseconds>(t6 - t5) << "\n"
+		<< "histograms match: " << (counts_binary == counts_fused && counts_binary == counts_parallel) << "\n"
+		<< "sums match: " << (sums_binary == sums_fused && sums_binary == sums_parallel) << "\n";
+
+	return 0;
+}
+
+int main_piecewise() {
+	// Calibration curve through 100'000 points, evaluated inside of its range
+	std::vector<float> xs = {};
+	std::vector<float> ys = {};
+	for (std::size_t i = 0; i < 100'000; i++) {
+		xs.push_back((float)i);
+		ys.push_back((float)((i * 7'919) % 1'000));
+	}
+	// What we do today: an index, then the coefficients from a separate array
+	std::vector<float> slopes = {};
+	for (std::size_t i = 0; i + 1 < xs.size(); i++) {
+		slopes.push_back((ys[i + 1] - ys[i]) / (xs[i + 1] - xs[i]));
+	}
+	auto jit_kary = ExeIntervalSearch(xs, { .layout = IntervalSearchLayout::KARY_AVX_8 });
+
+	auto t0 = std::chrono::high_resolution_clock::now();
+	auto jit = ExePiecewise(xs, piecewise_linear(xs, ys));
+	auto t1 = std::chrono::high_resolution_clock::now();
+
+	int32_t steps = 50'000'000;
+	uint64_t state = 88'172'645'463'325'252ull;
+	std::vector<float> values(steps);
+	for (auto& value : values) {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		// Well below xs.back(), values close to it round up to it in float
+		value = (float)(state % 99'990'000) / 1'000.0f;
+	}
+	std::vector<float> reference(steps);
+	std::vector<float> kary_results(steps);
+	std::vector<float> scalar_results(steps);
+	std::vector<float> batch_results(steps);
+
+	auto t2 = std::chrono::high_resolution_clock::now();
+	for (int32_t i = 0; i < steps; i++) {
+		float x = values[i];
+		int32_t index = interval_search_binary(xs, x);
+		reference[i] = ys[index] + slopes[index] * (x - xs[index]);
+	}
+	auto t3 = std::chrono::high_resolution_clock::now();
+	for (int32_t i = 0; i < steps; i++) {
+		float x = values[i];
+		int32_t index = jit_kary.run(x);
+		kary_results[i] = ys[index] + slopes[index] * (x - xs[index]);
+	}
+	auto t4 = std::chrono::high_resolution_clock::now();
+	for (int32_t i = 0; i < steps; i++) {
+		scalar_results[i] = jit.run(values[i]);
+	}
+	auto t5 = std::chrono::high_resolution_clock::now();
+	jit.run_batch(values.data(), batch_results.data(), values.size());
+	auto t6 = std::chrono::high_resolution_clock::now();
+
+	// Outside of [xs.front(), xs.back()) the pieces are the end values, which the reference has no index for
+	const float outside[] = { -5.0f, xs.back(), xs.back() + 5.0f };
+	bool outside_match = jit.run(outside[0]) == ys.front() && jit.run(outside[1]) == ys.back() && jit.run(outside[2]) == ys.back();
+	float outside_results[3] = {};
+	jit.run_batch(outside, outside_results, 3);
+	outside_match &= outside_results[0] == ys.front() && outside_results[1] == ys.back() && outside_results[2] == ys.back();
+
+	// Same float operations in the same order, so the results are equal and not just close
+	std::cout
+		<< "Points: " << xs.size() << ", evaluations: " << steps << "\n"
+		<< "Binary search + coefficient arrays: " << std::chrono::duration_cast<std::chrono::milliseconds>(t3 - t2) << "\n"
+		<< "JIT k-ary + coefficient arrays: " << std::chrono::duration_cast<std::chrono::milliseconds>(t4 - t3) << "\n"
+		<< "JIT piecewise: " << std::chrono::duration_cast<std::chrono::milliseconds>(t5 - t4)
+		<< ", compilation: " << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0) << "\n"
+		<< "JIT piecewise batch: " << std::chrono::duration_cast<std::chrono::milliseconds>(t6 - t5) << "\n"
+		<< "results match: " << (kary_results == reference && scalar_results == reference && batch_results == reference && outside_match) << "\n";
 
 	return 0;
 }
@@ -213,6 +758,14 @@ int main_jitable() {
 int main() {
 	// main_jitree();
 	main_jitable();
+	// main_static();
+	// main_grid();
+	// main_jitable_set();
+	// main_jitstring();
+	// main_tiered();
+	// main_pipeline();
+	// main_aggregate();
+	// main_piecewise();
 
 	return 0;
 }
\ No newline at end of file